@@ -116,6 +116,7 @@ LRESULT CALLBACK on_window_event(
 void on_dll_unload(Application* application) {
 	application->engine.scene_manager.HOT_RELOAD_unregister_all_scenes();
 	application->engine.screen_stack.HOT_RELOAD_unregister_all_screens();
+	application->engine.renderer.HOT_RELOAD_stop_render_threads();
 }
 
 void on_dll_reloaded(Application* application) {
@@ -171,7 +172,7 @@ bool update_application(Application* app) {
 
 		/* Render */
 		app->engine.renderer.render(app->engine.resources);
-		app->engine.window.render(app->engine.renderer.bitmap());
+		app->engine.window.render(app->engine.renderer.bitmap(), app->engine.renderer.dirty_rects());
 
 		/* Yield CPU to not stall OS */
 		Sleep(1);
@@ -0,0 +1,51 @@
+#include <engine/container/linear_arena.h>
+
+#include <engine/debug/assert.h>
+
+#include <algorithm>
+#include <string.h>
+
+namespace engine {
+
+	ArenaString LinearArena::push_string(std::string_view string) {
+		ArenaString arena_string = {
+			.offset = _allocate(string.size()),
+			.length = (uint32_t)string.size(),
+		};
+		if (!string.empty()) {
+			memcpy(&m_buffer[arena_string.offset], string.data(), string.size());
+		}
+		return arena_string;
+	}
+
+	std::string_view LinearArena::string(ArenaString string) const {
+		if (string.length == 0) {
+			return std::string_view();
+		}
+		return std::string_view(reinterpret_cast<const char*>(&m_buffer[string.offset]), string.length);
+	}
+
+	void LinearArena::clear() {
+		m_size = 0;
+	}
+
+	uint32_t LinearArena::size() const {
+		return m_size;
+	}
+
+	size_t LinearArena::capacity() const {
+		return m_buffer.size();
+	}
+
+	uint32_t LinearArena::_allocate(size_t size) {
+		const size_t offset = (m_size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+		const size_t end = offset + size;
+		DEBUG_ASSERT(end <= UINT32_MAX, "LinearArena can't grow past 4 GB");
+		if (end > m_buffer.size()) {
+			m_buffer.resize(std::max(end, 2 * m_buffer.size()));
+		}
+		m_size = (uint32_t)end;
+		return (uint32_t)offset;
+	}
+
+} // namespace engine
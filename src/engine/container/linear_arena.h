@@ -0,0 +1,91 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <span>
+#include <string_view>
+#include <type_traits>
+#include <vector>
+
+namespace engine {
+
+	// String stored in a LinearArena
+	struct ArenaString {
+		uint32_t offset = 0;
+		uint32_t length = 0;
+	};
+
+	// Array stored in a LinearArena
+	template <typename T>
+	struct ArenaSpan {
+		uint32_t offset = 0;
+		uint32_t length = 0;
+	};
+
+	// Bump allocator over a single growable block of memory
+	//
+	// Meant to be filled up and cleared every frame. Clearing keeps the memory
+	// around, so once the arena has grown to fit a frame it stops allocating.
+	// Since growing moves the block, allocations are referred to by offset.
+	class LinearArena {
+	public:
+		static constexpr size_t ALIGNMENT = 8;
+
+		template <typename T>
+		uint32_t push(const T& value) {
+			static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>, "arena values are never destroyed");
+			static_assert(alignof(T) <= ALIGNMENT);
+			uint32_t offset = _allocate(sizeof(T));
+			new (&m_buffer[offset]) T(value);
+			return offset;
+		}
+
+		template <typename T>
+		T& get(uint32_t offset) {
+			return *std::launder(reinterpret_cast<T*>(&m_buffer[offset]));
+		}
+
+		template <typename T>
+		const T& get(uint32_t offset) const {
+			return *std::launder(reinterpret_cast<const T*>(&m_buffer[offset]));
+		}
+
+		template <typename T>
+		ArenaSpan<T> push_span(std::span<const T> values) {
+			static_assert(std::is_trivially_copyable_v<T> && std::is_trivially_destructible_v<T>, "arena values are never destroyed");
+			static_assert(alignof(T) <= ALIGNMENT);
+			ArenaSpan<T> arena_span = {
+				.offset = _allocate(values.size_bytes()),
+				.length = (uint32_t)values.size(),
+			};
+			if (!values.empty()) {
+				memcpy(&m_buffer[arena_span.offset], values.data(), values.size_bytes());
+			}
+			return arena_span;
+		}
+
+		template <typename T>
+		std::span<const T> span(ArenaSpan<T> arena_span) const {
+			if (arena_span.length == 0) {
+				return std::span<const T>();
+			}
+			return std::span<const T>(std::launder(reinterpret_cast<const T*>(&m_buffer[arena_span.offset])), arena_span.length);
+		}
+
+		ArenaString push_string(std::string_view string);
+		std::string_view string(ArenaString string) const;
+
+		void clear();
+		uint32_t size() const;
+		size_t capacity() const;
+
+	private:
+		uint32_t _allocate(size_t size);
+
+		std::vector<std::byte> m_buffer;
+		uint32_t m_size = 0;
+	};
+
+} // namespace engine
@@ -0,0 +1,51 @@
+#include <engine/container/radix_sort.h>
+
+#include <engine/debug/assert.h>
+
+#include <array>
+#include <utility>
+
+namespace engine {
+
+	void RadixSorter::sort(std::vector<uint64_t>* keys, std::vector<uint32_t>* values) {
+		DEBUG_ASSERT(keys->size() == values->size(), "Every key needs a value");
+		const size_t num_keys = keys->size();
+		if (num_keys < 2) {
+			return;
+		}
+
+		/* Count occurrences of each byte value for all passes at once */
+		std::array<std::array<uint32_t, 256>, sizeof(uint64_t)> counts = {};
+		for (uint64_t key : *keys) {
+			for (size_t pass = 0; pass < sizeof(uint64_t); pass++) {
+				counts[pass][(key >> (8 * pass)) & 0xFF]++;
+			}
+		}
+
+		m_scratch_keys.resize(num_keys);
+		m_scratch_values.resize(num_keys);
+		for (size_t pass = 0; pass < sizeof(uint64_t); pass++) {
+			/* Skip pass if all keys have the same byte */
+			const uint64_t shift = 8 * pass;
+			if (counts[pass][((*keys)[0] >> shift) & 0xFF] == num_keys) {
+				continue;
+			}
+
+			/* Scatter keys into buckets, keeping their order within a bucket */
+			std::array<uint32_t, 256> offsets;
+			uint32_t offset = 0;
+			for (size_t byte = 0; byte < 256; byte++) {
+				offsets[byte] = offset;
+				offset += counts[pass][byte];
+			}
+			for (size_t i = 0; i < num_keys; i++) {
+				const uint32_t destination = offsets[((*keys)[i] >> shift) & 0xFF]++;
+				m_scratch_keys[destination] = (*keys)[i];
+				m_scratch_values[destination] = (*values)[i];
+			}
+			std::swap(*keys, m_scratch_keys);
+			std::swap(*values, m_scratch_values);
+		}
+	}
+
+} // namespace engine
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+namespace engine {
+
+	// Stable least significant digit radix sort of 64-bit keys, one byte per pass
+	//
+	// Values are moved along with their keys. Passes over bytes that are the same
+	// for every key are skipped, so keys only using a few of their bits sort in a
+	// few passes. Scratch memory is kept between sorts.
+	class RadixSorter {
+	public:
+		void sort(std::vector<uint64_t>* keys, std::vector<uint32_t>* values);
+
+	private:
+		std::vector<uint64_t> m_scratch_keys;
+		std::vector<uint32_t> m_scratch_values;
+	};
+
+} // namespace engine
@@ -12,6 +12,10 @@ namespace engine {
 
 	struct EngineArgs {
 		int test_screen_page = 0;
+		bool tiled_rendering = false;
+		bool dirty_rect_tracking = false;
+		bool debug_draw_dirty_rects = false;
+		bool frame_skipping = false;
 	};
 
 	std::optional<int64_t> parse_numeric_arg(const std::string& string, const std::string& arg_string) {
@@ -28,6 +32,19 @@ namespace engine {
 			if (std::optional<int64_t> test_screen_page = parse_numeric_arg(arg, "--test-screen-page=")) {
 				engine_args.test_screen_page = (int32_t)test_screen_page.value() - 1;
 			}
+			if (arg == "--tiled-rendering") {
+				engine_args.tiled_rendering = true;
+			}
+			if (arg == "--dirty-rects") {
+				engine_args.dirty_rect_tracking = true;
+			}
+			if (arg == "--debug-dirty-rects") {
+				engine_args.dirty_rect_tracking = true;
+				engine_args.debug_draw_dirty_rects = true;
+			}
+			if (arg == "--frame-skipping") {
+				engine_args.frame_skipping = true;
+			}
 		}
 
 		return engine_args;
@@ -58,6 +75,10 @@ namespace engine {
 		}
 		engine.resources = resources.value();
 		engine.renderer = Renderer::with_bitmap(screen_resolution.x, screen_resolution.y);
+		engine.renderer.set_tiled_rendering(engine_args.tiled_rendering);
+		engine.renderer.set_dirty_rect_tracking(engine_args.dirty_rect_tracking);
+		engine.renderer.set_debug_draw_dirty_rects(engine_args.debug_draw_dirty_rects);
+		engine.renderer.set_frame_skipping(engine_args.frame_skipping);
 		initialize_gamepad_support();
 
 		return engine;
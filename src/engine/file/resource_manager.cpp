@@ -9,21 +9,13 @@ namespace engine {
 		ResourceManager resources;
 
 		/* Load missing image texture */
-		resources.m_images.insert(
-			{
-				INVALID_IMAGE_ID.value,
-				Image {
-					.width = 2,
-					.height = 2,
-					.pixels = {
-						Color::black(),
-						Color::purple(),
-						Color::purple(),
-						Color::black(),
-					},
-				},
-			}
-		);
+		const Color missing_image_colors[] = {
+			Color::black(),
+			Color::purple(),
+			Color::purple(),
+			Color::black(),
+		};
+		resources.m_images.insert({ INVALID_IMAGE_ID.value, Image::from_colors(2, 2, missing_image_colors) });
 
 		/* Load default font */
 		if (std::optional<Typeface> typeface = Typeface::from_path(default_font_path)) {
@@ -37,14 +29,20 @@ namespace engine {
 		return resources;
 	}
 
-	ImageID ResourceManager::load_image(std::filesystem::path filepath) {
+	ImageID ResourceManager::load_image(std::filesystem::path filepath, LoadImageOptions options) {
 		/* Check if already loaded */
 		if (auto it = m_image_ids.find(filepath); it != m_image_ids.end()) {
+			if (options.indexed) {
+				m_images[it->second].build_indices();
+			}
 			return ImageID(it->second);
 		}
 
 		/* Load and store image */
 		if (std::optional<Image> image = Image::from_path(filepath)) {
+			if (options.indexed) {
+				image->build_indices();
+			}
 			ImageID id = ImageID(m_next_image_id++);
 			m_images[id.value] = image.value();
 			return id;
@@ -72,6 +70,12 @@ namespace engine {
 		return INVALID_FONT_ID;
 	}
 
+	TileMapID ResourceManager::add_tilemap(TileMap tilemap) {
+		TileMapID id = TileMapID(m_next_tilemap_id++);
+		m_tilemaps[id.value] = std::move(tilemap);
+		return id;
+	}
+
 	const Image& ResourceManager::image(ImageID id) const {
 		auto it = m_images.find(id.value);
 		if (it == m_images.end()) {
@@ -91,4 +95,14 @@ namespace engine {
 		return m_typefaces.at(id.value);
 	}
 
+	TileMap& ResourceManager::tilemap(TileMapID id) {
+		DEBUG_ASSERT(m_tilemaps.contains(id.value), "Trying to access non-existing tilemap using id %d", id.value);
+		return m_tilemaps.at(id.value);
+	}
+
+	const TileMap& ResourceManager::tilemap(TileMapID id) const {
+		DEBUG_ASSERT(m_tilemaps.contains(id.value), "Trying to access non-existing tilemap using id %d", id.value);
+		return m_tilemaps.at(id.value);
+	}
+
 } // namespace engine
@@ -4,6 +4,8 @@
 #include <engine/graphics/font_id.h>
 #include <engine/graphics/image.h>
 #include <engine/graphics/image_id.h>
+#include <engine/graphics/tilemap.h>
+#include <engine/graphics/tilemap_id.h>
 
 #include <filesystem>
 #include <optional>
@@ -11,14 +13,21 @@
 
 namespace engine {
 
+	struct LoadImageOptions {
+		bool indexed = false; // keep an 8-bit indexed copy for palette swaps, if it has at most 256 colors
+	};
+
 	class ResourceManager {
 	public:
 		static std::optional<ResourceManager> initialize(std::filesystem::path default_font_path);
-		ImageID load_image(std::filesystem::path filepath);
+		ImageID load_image(std::filesystem::path filepath, LoadImageOptions options = {});
 		FontID load_font(std::filesystem::path filepath);
+		TileMapID add_tilemap(TileMap tilemap);
 		const Image& image(ImageID id) const;
 		Typeface& typeface(FontID id);
 		const Typeface& typeface(FontID id) const;
+		TileMap& tilemap(TileMapID id);
+		const TileMap& tilemap(TileMapID id) const;
 
 	private:
 		int m_next_image_id = 1;
@@ -28,6 +37,9 @@ namespace engine {
 		int m_next_font_id = 2;
 		std::unordered_map<std::filesystem::path, int> m_typeface_ids;
 		std::unordered_map<int, Typeface> m_typefaces;
+
+		int m_next_tilemap_id = 1;
+		std::unordered_map<int, TileMap> m_tilemaps;
 	};
 
 } // namespace engine
@@ -2,22 +2,207 @@
 
 #include <engine/math/math.h>
 
+#include <bit>
+#include <cmath>
+#include <string.h>
+
+#if defined(__AVX2__) || defined(_M_X64) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 namespace engine {
 
-	Pixel Pixel::from_color(Color color) {
+	// Exact floor(x / 255) for 0 <= x <= 255 * 255
+	static inline uint32_t div_255(uint32_t x) {
+		return (x + 1 + (x >> 8)) >> 8;
+	}
+
+	// Leaves the padding byte of `dst` as is
+	static inline Pixel blend_pixel(Pixel dst, Pixel src, uint32_t alpha) {
+		const uint32_t inv_alpha = 255 - alpha;
 		return Pixel {
-			.b = color.b,
-			.g = color.g,
-			.r = color.r,
+			.b = (uint8_t)div_255(dst.b * inv_alpha + src.b * alpha),
+			.g = (uint8_t)div_255(dst.g * inv_alpha + src.g * alpha),
+			.r = (uint8_t)div_255(dst.r * inv_alpha + src.r * alpha),
+			.a = dst.a,
 		};
 	}
 
-	Pixel Pixel::lerp(Pixel rhs, float t) const {
+	static inline uint8_t alpha_to_byte(float alpha) {
+		return (uint8_t)engine::clamp((int32_t)std::lround(alpha * 255.0f), 0, 255);
+	}
+
+	static inline Pixel blend_premultiplied_pixel(Pixel dst, Pixel src) {
+		const uint32_t inv_alpha = 255 - src.a;
 		return Pixel {
-			.b = (uint8_t)engine::lerp(this->b, rhs.b, t),
-			.g = (uint8_t)engine::lerp(this->g, rhs.g, t),
-			.r = (uint8_t)engine::lerp(this->r, rhs.r, t),
+			.b = (uint8_t)(src.b + div_255(dst.b * inv_alpha)),
+			.g = (uint8_t)(src.g + div_255(dst.g * inv_alpha)),
+			.r = (uint8_t)(src.r + div_255(dst.r * inv_alpha)),
+			.a = (uint8_t)(src.a + div_255(dst.a * inv_alpha)),
+		};
+	}
+
+#if defined(__AVX2__) || defined(_M_X64) || defined(__SSE2__)
+	// SSE2 is always available on x64, so it's used as the baseline kernel.
+	// `alpha` holds one alpha value per channel byte of the 4 pixels, and the
+	// padding byte is zeroed so `dst` keeps its own like in blend_pixel().
+	static inline __m128i blend_4_pixels(__m128i dst, __m128i src, __m128i alpha) {
+		alpha = _mm_and_si128(alpha, _mm_set1_epi32(0x00FFFFFF));
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i one = _mm_set1_epi16(1);
+		const __m128i max_alpha = _mm_set1_epi16(255);
+		auto blend_half = [&](__m128i dst16, __m128i src16, __m128i alpha16) {
+			__m128i x = _mm_add_epi16(_mm_mullo_epi16(dst16, _mm_sub_epi16(max_alpha, alpha16)), _mm_mullo_epi16(src16, alpha16));
+			return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, one), _mm_srli_epi16(x, 8)), 8); // div_255
+		};
+		__m128i lo = blend_half(_mm_unpacklo_epi8(dst, zero), _mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(alpha, zero));
+		__m128i hi = blend_half(_mm_unpackhi_epi8(dst, zero), _mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(alpha, zero));
+		return _mm_packus_epi16(lo, hi);
+	}
+
+	// Converts 4 RGBA colors to BGR pixels with zero padding, and returns the
+	// alpha of each color spread out over all of its channel bytes.
+	static inline __m128i colors_to_4_pixels(__m128i colors, __m128i* alpha_channels) {
+		const __m128i green_mask = _mm_set1_epi32(0x0000FF00);
+		const __m128i low_byte_mask = _mm_set1_epi32(0x000000FF);
+		__m128i red = _mm_slli_epi32(_mm_and_si128(colors, low_byte_mask), 16);
+		__m128i blue = _mm_and_si128(_mm_srli_epi32(colors, 16), low_byte_mask);
+		__m128i alpha = _mm_srli_epi32(colors, 24);
+		alpha = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 8));
+		*alpha_channels = _mm_or_si128(alpha, _mm_slli_epi32(alpha, 16));
+		return _mm_or_si128(_mm_or_si128(red, blue), _mm_and_si128(colors, green_mask));
+	}
+
+	// Blends 4 premultiplied pixels over `dst`. Premultiplied channels never
+	// exceed their alpha, so adding them can't overflow.
+	static inline __m128i blend_4_premultiplied_pixels(__m128i dst, __m128i src) {
+		const __m128i zero = _mm_setzero_si128();
+		const __m128i one = _mm_set1_epi16(1);
+		__m128i inv_alpha = _mm_srli_epi32(_mm_xor_si128(src, _mm_set1_epi32(-1)), 24);
+		inv_alpha = _mm_or_si128(inv_alpha, _mm_slli_epi32(inv_alpha, 8));
+		inv_alpha = _mm_or_si128(inv_alpha, _mm_slli_epi32(inv_alpha, 16));
+		auto scale_half = [&](__m128i dst16, __m128i inv_alpha16) {
+			__m128i x = _mm_mullo_epi16(dst16, inv_alpha16);
+			return _mm_srli_epi16(_mm_add_epi16(_mm_add_epi16(x, one), _mm_srli_epi16(x, 8)), 8); // div_255
+		};
+		__m128i lo = scale_half(_mm_unpacklo_epi8(dst, zero), _mm_unpacklo_epi8(inv_alpha, zero));
+		__m128i hi = scale_half(_mm_unpackhi_epi8(dst, zero), _mm_unpackhi_epi8(inv_alpha, zero));
+		return _mm_add_epi8(_mm_packus_epi16(lo, hi), src);
+	}
+
+	static inline __m128i expand_4_alphas(uint32_t alphas) {
+		__m128i alpha = _mm_cvtsi32_si128((int32_t)alphas);
+		alpha = _mm_unpacklo_epi8(alpha, alpha); // a0 a0 a1 a1 a2 a2 a3 a3
+		return _mm_unpacklo_epi16(alpha, alpha); // a0 a0 a0 a0 a1 a1 a1 a1 ...
+	}
+#endif
+
+#if defined(__AVX2__)
+	static inline __m256i blend_8_pixels(__m256i dst, __m256i src, __m256i alpha) {
+		// unpack and pack both work per 128-bit lane, so pixel order is kept
+		alpha = _mm256_and_si256(alpha, _mm256_set1_epi32(0x00FFFFFF));
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i one = _mm256_set1_epi16(1);
+		const __m256i max_alpha = _mm256_set1_epi16(255);
+		auto blend_half = [&](__m256i dst16, __m256i src16, __m256i alpha16) {
+			__m256i x = _mm256_add_epi16(_mm256_mullo_epi16(dst16, _mm256_sub_epi16(max_alpha, alpha16)), _mm256_mullo_epi16(src16, alpha16));
+			return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(x, one), _mm256_srli_epi16(x, 8)), 8); // div_255
+		};
+		__m256i lo = blend_half(_mm256_unpacklo_epi8(dst, zero), _mm256_unpacklo_epi8(src, zero), _mm256_unpacklo_epi8(alpha, zero));
+		__m256i hi = blend_half(_mm256_unpackhi_epi8(dst, zero), _mm256_unpackhi_epi8(src, zero), _mm256_unpackhi_epi8(alpha, zero));
+		return _mm256_packus_epi16(lo, hi);
+	}
+
+	static inline __m256i colors_to_8_pixels(__m256i colors, __m256i* alpha_channels) {
+		const __m256i green_mask = _mm256_set1_epi32(0x0000FF00);
+		const __m256i low_byte_mask = _mm256_set1_epi32(0x000000FF);
+		__m256i red = _mm256_slli_epi32(_mm256_and_si256(colors, low_byte_mask), 16);
+		__m256i blue = _mm256_and_si256(_mm256_srli_epi32(colors, 16), low_byte_mask);
+		__m256i alpha = _mm256_srli_epi32(colors, 24);
+		*alpha_channels = _mm256_mullo_epi32(alpha, _mm256_set1_epi32(0x01010101));
+		return _mm256_or_si256(_mm256_or_si256(red, blue), _mm256_and_si256(colors, green_mask));
+	}
+
+	static inline __m256i blend_8_premultiplied_pixels(__m256i dst, __m256i src) {
+		const __m256i zero = _mm256_setzero_si256();
+		const __m256i one = _mm256_set1_epi16(1);
+		__m256i inv_alpha = _mm256_srli_epi32(_mm256_xor_si256(src, _mm256_set1_epi32(-1)), 24);
+		inv_alpha = _mm256_mullo_epi32(inv_alpha, _mm256_set1_epi32(0x01010101));
+		auto scale_half = [&](__m256i dst16, __m256i inv_alpha16) {
+			__m256i x = _mm256_mullo_epi16(dst16, inv_alpha16);
+			return _mm256_srli_epi16(_mm256_add_epi16(_mm256_add_epi16(x, one), _mm256_srli_epi16(x, 8)), 8); // div_255
 		};
+		__m256i lo = scale_half(_mm256_unpacklo_epi8(dst, zero), _mm256_unpacklo_epi8(inv_alpha, zero));
+		__m256i hi = scale_half(_mm256_unpackhi_epi8(dst, zero), _mm256_unpackhi_epi8(inv_alpha, zero));
+		return _mm256_add_epi8(_mm256_packus_epi16(lo, hi), src);
+	}
+
+	static inline __m256i expand_8_alphas(uint64_t alphas) {
+		__m256i alpha = _mm256_cvtepu8_epi32(_mm_cvtsi64_si128((int64_t)alphas));
+		return _mm256_mullo_epi32(alpha, _mm256_set1_epi32(0x01010101));
+	}
+#endif
+
+	// Blends `length` pixels into `dst`, with source color and alpha either
+	// constant or read per pixel from `src_pixels` and `alphas`.
+	template <bool per_pixel_color, bool per_pixel_alpha>
+	static void blend_pixels(Pixel* dst, int32_t length, const Pixel* src_pixels, Pixel src_pixel, const uint8_t* alphas, uint8_t alpha) {
+		int32_t i = 0;
+#if defined(__AVX2__)
+		const __m256i src_8 = _mm256_set1_epi32(std::bit_cast<int32_t>(src_pixel));
+		const __m256i alpha_8 = _mm256_set1_epi8((char)alpha);
+		for (; i + 8 <= length; i += 8) {
+			__m256i src = src_8;
+			__m256i alpha_channels = alpha_8;
+			if constexpr (per_pixel_color) {
+				src = _mm256_loadu_si256((const __m256i*)(src_pixels + i));
+			}
+			if constexpr (per_pixel_alpha) {
+				uint64_t packed_alphas;
+				memcpy(&packed_alphas, alphas + i, sizeof(packed_alphas));
+				if (packed_alphas == 0) {
+					continue;
+				}
+				if (packed_alphas == UINT64_MAX) {
+					_mm256_storeu_si256((__m256i*)(dst + i), src);
+					continue;
+				}
+				alpha_channels = expand_8_alphas(packed_alphas);
+			}
+			__m256i blended = blend_8_pixels(_mm256_loadu_si256((const __m256i*)(dst + i)), src, alpha_channels);
+			_mm256_storeu_si256((__m256i*)(dst + i), blended);
+		}
+#endif
+#if defined(__AVX2__) || defined(_M_X64) || defined(__SSE2__)
+		const __m128i src_4 = _mm_set1_epi32(std::bit_cast<int32_t>(src_pixel));
+		const __m128i alpha_4 = _mm_set1_epi8((char)alpha);
+		for (; i + 4 <= length; i += 4) {
+			__m128i src = src_4;
+			__m128i alpha_channels = alpha_4;
+			if constexpr (per_pixel_color) {
+				src = _mm_loadu_si128((const __m128i*)(src_pixels + i));
+			}
+			if constexpr (per_pixel_alpha) {
+				uint32_t packed_alphas;
+				memcpy(&packed_alphas, alphas + i, sizeof(packed_alphas));
+				if (packed_alphas == 0) {
+					continue;
+				}
+				if (packed_alphas == UINT32_MAX) {
+					_mm_storeu_si128((__m128i*)(dst + i), src);
+					continue;
+				}
+				alpha_channels = expand_4_alphas(packed_alphas);
+			}
+			__m128i blended = blend_4_pixels(_mm_loadu_si128((const __m128i*)(dst + i)), src, alpha_channels);
+			_mm_storeu_si128((__m128i*)(dst + i), blended);
+		}
+#endif
+		for (; i < length; i++) {
+			Pixel src = per_pixel_color ? src_pixels[i] : src_pixel;
+			uint8_t src_alpha = per_pixel_alpha ? alphas[i] : alpha;
+			dst[i] = blend_pixel(dst[i], src, src_alpha);
+		}
 	}
 
 	Bitmap Bitmap::with_size(int32_t width, int32_t height) {
@@ -29,9 +214,9 @@ namespace engine {
 	}
 
 	Image Bitmap::to_image() const {
-		Image image = { .width = m_width, .height = m_height };
+		Image image = { .width = m_width, .height = m_height, .alpha_mode = AlphaMode::Opaque };
 		for (const Pixel& pixel : m_data) {
-			image.pixels.push_back({ pixel.r, pixel.g, pixel.b, 255 });
+			image.pixels.push_back({ pixel.b, pixel.g, pixel.r, 255 });
 		}
 		return image;
 	}
@@ -52,14 +237,222 @@ namespace engine {
 				m_data[x + m_width * y] = pixel;
 			}
 			else {
+				// Same 8-bit blend as blend_span(), since float lerp can land just below whole values
 				Pixel& bitmap_pixel = m_data[x + m_width * y];
-				bitmap_pixel.b = (uint8_t)engine::lerp(bitmap_pixel.b, pixel.b, alpha);
-				bitmap_pixel.g = (uint8_t)engine::lerp(bitmap_pixel.g, pixel.g, alpha);
-				bitmap_pixel.r = (uint8_t)engine::lerp(bitmap_pixel.r, pixel.r, alpha);
+				bitmap_pixel = blend_pixel(bitmap_pixel, pixel, alpha_to_byte(alpha));
+			}
+		}
+	}
+
+	// Blends `length` straight alpha colors into `dst`, reading `src` backwards if `reversed`
+	template <bool reversed>
+	static void blend_colors(Pixel* dst, int32_t length, const Color* src) {
+		int32_t i = 0;
+#if defined(__AVX2__)
+		const __m256i reverse_8 = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+		for (; i + 8 <= length; i += 8) {
+			__m256i colors = _mm256_loadu_si256((const __m256i*)(reversed ? src - i - 7 : src + i));
+			if constexpr (reversed) {
+				colors = _mm256_permutevar8x32_epi32(colors, reverse_8);
+			}
+			__m256i alpha_channels;
+			__m256i pixels = colors_to_8_pixels(colors, &alpha_channels);
+			uint32_t opaque_mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(alpha_channels, _mm256_set1_epi8(-1)));
+			uint32_t transparent_mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi8(alpha_channels, _mm256_setzero_si256()));
+			if (transparent_mask == UINT32_MAX) {
+				continue;
+			}
+			if (opaque_mask != UINT32_MAX) {
+				pixels = blend_8_pixels(_mm256_loadu_si256((const __m256i*)(dst + i)), pixels, alpha_channels);
+			}
+			_mm256_storeu_si256((__m256i*)(dst + i), pixels);
+		}
+#endif
+#if defined(__AVX2__) || defined(_M_X64) || defined(__SSE2__)
+		for (; i + 4 <= length; i += 4) {
+			__m128i colors = _mm_loadu_si128((const __m128i*)(reversed ? src - i - 3 : src + i));
+			if constexpr (reversed) {
+				colors = _mm_shuffle_epi32(colors, _MM_SHUFFLE(0, 1, 2, 3));
+			}
+			__m128i alpha_channels;
+			__m128i pixels = colors_to_4_pixels(colors, &alpha_channels);
+			int32_t opaque_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(alpha_channels, _mm_set1_epi8(-1)));
+			int32_t transparent_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(alpha_channels, _mm_setzero_si128()));
+			if (transparent_mask == 0xFFFF) {
+				continue;
+			}
+			if (opaque_mask != 0xFFFF) {
+				pixels = blend_4_pixels(_mm_loadu_si128((const __m128i*)(dst + i)), pixels, alpha_channels);
+			}
+			_mm_storeu_si128((__m128i*)(dst + i), pixels);
+		}
+#endif
+		for (; i < length; i++) {
+			Color color = reversed ? src[-i] : src[i];
+			if (color.a == 255) {
+				dst[i] = Pixel::from_color(color);
+			}
+			else if (color.a > 0) {
+				dst[i] = blend_pixel(dst[i], Pixel::from_color(color), color.a);
 			}
 		}
 	}
 
+	// Blends `length` premultiplied pixels into `dst`, reading `src` backwards if `reversed`
+	template <AlphaMode alpha_mode, bool reversed>
+	static void blend_premultiplied_pixels(Pixel* dst, int32_t length, const Pixel* src) {
+		if constexpr (alpha_mode == AlphaMode::Opaque && !reversed) {
+			memcpy(dst, src, length * sizeof(Pixel));
+			return;
+		}
+		int32_t i = 0;
+#if defined(__AVX2__)
+		const __m256i reverse_8 = _mm256_setr_epi32(7, 6, 5, 4, 3, 2, 1, 0);
+		for (; i + 8 <= length; i += 8) {
+			__m256i pixels = _mm256_loadu_si256((const __m256i*)(reversed ? src - i - 7 : src + i));
+			if constexpr (reversed) {
+				pixels = _mm256_permutevar8x32_epi32(pixels, reverse_8);
+			}
+			if constexpr (alpha_mode == AlphaMode::Binary) {
+				__m256i opaque = _mm256_srai_epi32(pixels, 31);
+				pixels = _mm256_or_si256(_mm256_and_si256(opaque, pixels), _mm256_andnot_si256(opaque, _mm256_loadu_si256((const __m256i*)(dst + i))));
+			}
+			if constexpr (alpha_mode == AlphaMode::Blended) {
+				__m256i alphas = _mm256_srli_epi32(pixels, 24);
+				uint32_t opaque_mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi32(alphas, _mm256_set1_epi32(255)));
+				uint32_t transparent_mask = (uint32_t)_mm256_movemask_epi8(_mm256_cmpeq_epi32(alphas, _mm256_setzero_si256()));
+				if (transparent_mask == UINT32_MAX) {
+					continue;
+				}
+				if (opaque_mask != UINT32_MAX) {
+					pixels = blend_8_premultiplied_pixels(_mm256_loadu_si256((const __m256i*)(dst + i)), pixels);
+				}
+			}
+			_mm256_storeu_si256((__m256i*)(dst + i), pixels);
+		}
+#endif
+#if defined(__AVX2__) || defined(_M_X64) || defined(__SSE2__)
+		for (; i + 4 <= length; i += 4) {
+			__m128i pixels = _mm_loadu_si128((const __m128i*)(reversed ? src - i - 3 : src + i));
+			if constexpr (reversed) {
+				pixels = _mm_shuffle_epi32(pixels, _MM_SHUFFLE(0, 1, 2, 3));
+			}
+			if constexpr (alpha_mode == AlphaMode::Binary) {
+				__m128i opaque = _mm_srai_epi32(pixels, 31);
+				pixels = _mm_or_si128(_mm_and_si128(opaque, pixels), _mm_andnot_si128(opaque, _mm_loadu_si128((const __m128i*)(dst + i))));
+			}
+			if constexpr (alpha_mode == AlphaMode::Blended) {
+				__m128i alphas = _mm_srli_epi32(pixels, 24);
+				int32_t opaque_mask = _mm_movemask_epi8(_mm_cmpeq_epi32(alphas, _mm_set1_epi32(255)));
+				int32_t transparent_mask = _mm_movemask_epi8(_mm_cmpeq_epi32(alphas, _mm_setzero_si128()));
+				if (transparent_mask == 0xFFFF) {
+					continue;
+				}
+				if (opaque_mask != 0xFFFF) {
+					pixels = blend_4_premultiplied_pixels(_mm_loadu_si128((const __m128i*)(dst + i)), pixels);
+				}
+			}
+			_mm_storeu_si128((__m128i*)(dst + i), pixels);
+		}
+#endif
+		for (; i < length; i++) {
+			Pixel pixel = reversed ? src[-i] : src[i];
+			if (alpha_mode == AlphaMode::Opaque || pixel.a == 255) {
+				dst[i] = pixel;
+			}
+			else if (alpha_mode == AlphaMode::Blended && pixel.a > 0) {
+				dst[i] = blend_premultiplied_pixel(dst[i], pixel);
+			}
+		}
+	}
+
+	void Bitmap::put_span(int32_t x, int32_t y, int32_t length, Pixel pixel, float alpha) {
+		int32_t offset;
+		if (!_clip_span(&x, y, &length, &offset)) {
+			return;
+		}
+		Pixel* dst = &m_data[x + m_width * y];
+		if (alpha == 1.0f) {
+			std::fill_n(dst, length, pixel);
+			return;
+		}
+		const uint8_t alpha_byte = alpha_to_byte(alpha);
+		for (int32_t i = 0; i < length; i++) {
+			dst[i] = blend_pixel(dst[i], pixel, alpha_byte);
+		}
+	}
+
+	void Bitmap::fill_span(int32_t x, int32_t y, int32_t length, Pixel pixel) {
+		int32_t offset;
+		if (_clip_span(&x, y, &length, &offset)) {
+			std::fill_n(&m_data[x + m_width * y], length, pixel);
+		}
+	}
+
+	void Bitmap::copy_span(int32_t x, int32_t y, int32_t length, const Pixel* pixels) {
+		int32_t offset;
+		if (_clip_span(&x, y, &length, &offset)) {
+			memcpy(&m_data[x + m_width * y], pixels + offset, length * sizeof(Pixel));
+		}
+	}
+
+	void Bitmap::blend_span(int32_t x, int32_t y, int32_t length, Pixel pixel, uint8_t alpha) {
+		if (alpha == 255) {
+			fill_span(x, y, length, pixel);
+			return;
+		}
+		int32_t offset;
+		if (alpha > 0 && _clip_span(&x, y, &length, &offset)) {
+			blend_pixels<false, false>(&m_data[x + m_width * y], length, nullptr, pixel, nullptr, alpha);
+		}
+	}
+
+	void Bitmap::blend_span(int32_t x, int32_t y, int32_t length, Pixel pixel, const uint8_t* alphas) {
+		int32_t offset;
+		if (_clip_span(&x, y, &length, &offset)) {
+			blend_pixels<false, true>(&m_data[x + m_width * y], length, nullptr, pixel, alphas + offset, 0);
+		}
+	}
+
+	void Bitmap::blend_span(int32_t x, int32_t y, int32_t length, const Pixel* pixels, const uint8_t* alphas) {
+		int32_t offset;
+		if (_clip_span(&x, y, &length, &offset)) {
+			blend_pixels<true, true>(&m_data[x + m_width * y], length, pixels + offset, {}, alphas + offset, 0);
+		}
+	}
+
+	void Bitmap::blend_span(int32_t x, int32_t y, int32_t length, const Color* colors, bool reversed) {
+		int32_t offset;
+		if (_clip_span(&x, y, &length, &offset)) {
+			if (reversed) {
+				blend_colors<true>(&m_data[x + m_width * y], length, colors - offset);
+			}
+			else {
+				blend_colors<false>(&m_data[x + m_width * y], length, colors + offset);
+			}
+		}
+	}
+
+	void Bitmap::blend_span(int32_t x, int32_t y, int32_t length, const Pixel* premultiplied_pixels, AlphaMode alpha_mode, bool reversed) {
+		int32_t offset;
+		if (!_clip_span(&x, y, &length, &offset)) {
+			return;
+		}
+		Pixel* dst = &m_data[x + m_width * y];
+		const Pixel* src = reversed ? premultiplied_pixels - offset : premultiplied_pixels + offset;
+		switch (alpha_mode) {
+			case AlphaMode::Opaque:
+				reversed ? blend_premultiplied_pixels<AlphaMode::Opaque, true>(dst, length, src) : blend_premultiplied_pixels<AlphaMode::Opaque, false>(dst, length, src);
+				break;
+			case AlphaMode::Binary:
+				reversed ? blend_premultiplied_pixels<AlphaMode::Binary, true>(dst, length, src) : blend_premultiplied_pixels<AlphaMode::Binary, false>(dst, length, src);
+				break;
+			case AlphaMode::Blended:
+				reversed ? blend_premultiplied_pixels<AlphaMode::Blended, true>(dst, length, src) : blend_premultiplied_pixels<AlphaMode::Blended, false>(dst, length, src);
+				break;
+		}
+	}
+
 	Pixel Bitmap::get(int32_t x, int32_t y) {
 		if (0 <= x && x < m_width && 0 <= y && y < m_height) {
 			return m_data[x + m_width * y];
@@ -87,4 +480,16 @@ namespace engine {
 		return m_data.data();
 	}
 
+	bool Bitmap::_clip_span(int32_t* x, int32_t y, int32_t* length, int32_t* offset) const {
+		if (y < 0 || y >= m_height) {
+			return false;
+		}
+		int32_t start = engine::max(*x, 0);
+		int32_t end = engine::min(*x + *length, m_width);
+		*offset = start - *x;
+		*x = start;
+		*length = end - start;
+		return *length > 0;
+	}
+
 } // namespace engine
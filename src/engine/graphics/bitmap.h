@@ -2,6 +2,7 @@
 
 #include <engine/graphics/color.h>
 #include <engine/graphics/image.h>
+#include <engine/graphics/pixel.h>
 #include <engine/graphics/rect.h>
 
 #include <cmath>
@@ -10,19 +11,6 @@
 
 namespace engine {
 
-	// Win32 endian stuff means RGB is stored as BGR.
-	// For alignment reasons we also add `padding`.
-	struct Pixel {
-		uint8_t b;
-		uint8_t g;
-		uint8_t r;
-		uint8_t padding;
-
-		static Pixel from_color(Color color);
-		bool operator==(const Pixel& rhs) const = default;
-		Pixel lerp(Pixel rhs, float t) const;
-	};
-
 	class Bitmap {
 	public:
 		Bitmap() = default;
@@ -32,6 +20,19 @@ namespace engine {
 		void clear(Pixel color);
 		void resize(int32_t width, int32_t height);
 		void put(int32_t x, int32_t y, Pixel pixel, float alpha);
+		void put_span(int32_t x, int32_t y, int32_t length, Pixel pixel, float alpha); // same blending as put()
+
+		// Span functions write a horizontal run of `length` pixels starting at
+		// (x,y), skipping any pixels outside of the bitmap. Blending is done in
+		// 8-bit fixed point, where an alpha of 255 fully replaces the pixel.
+		void fill_span(int32_t x, int32_t y, int32_t length, Pixel pixel);
+		void copy_span(int32_t x, int32_t y, int32_t length, const Pixel* pixels);
+		void blend_span(int32_t x, int32_t y, int32_t length, Pixel pixel, uint8_t alpha);
+		void blend_span(int32_t x, int32_t y, int32_t length, Pixel pixel, const uint8_t* alphas);
+		void blend_span(int32_t x, int32_t y, int32_t length, const Pixel* pixels, const uint8_t* alphas);
+		void blend_span(int32_t x, int32_t y, int32_t length, const Color* colors, bool reversed); // reversed reads colors[0], colors[-1], ...
+		void blend_span(int32_t x, int32_t y, int32_t length, const Pixel* premultiplied_pixels, AlphaMode alpha_mode, bool reversed);
+
 		Pixel get(int32_t x, int32_t y);
 		bool empty() const;
 		int32_t width() const;
@@ -41,6 +42,8 @@ namespace engine {
 		bool operator==(const Bitmap& rhs) const = default;
 
 	private:
+		bool _clip_span(int32_t* x, int32_t y, int32_t* length, int32_t* offset) const;
+
 		int32_t m_width = 0;
 		int32_t m_height = 0;
 		std::vector<Pixel> m_data;
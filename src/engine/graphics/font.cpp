@@ -2,6 +2,7 @@
 
 #include <engine/debug/assert.h>
 
+#include <algorithm>
 #include <fstream>
 
 namespace engine {
@@ -10,12 +11,18 @@ namespace engine {
 		m_file_data = other.m_file_data;
 		stbtt_InitFont(&m_font_info, m_file_data.data(), 0);
 		m_fonts = other.m_fonts;
+		for (auto& [size, font] : m_fonts) {
+			_point_glyphs_into_atlas(&font);
+		}
 	}
 
 	Typeface& Typeface::operator=(const Typeface& other) noexcept {
 		m_file_data = other.m_file_data;
 		stbtt_InitFont(&m_font_info, m_file_data.data(), 0);
 		m_fonts = other.m_fonts;
+		for (auto& [size, font] : m_fonts) {
+			_point_glyphs_into_atlas(&font);
+		}
 		return *this;
 	}
 
@@ -65,25 +72,49 @@ namespace engine {
 	}
 
 	void Typeface::add_font(int32_t size) {
+		// Keep existing glyphs, since cached text layouts point to them
+		if (m_fonts.contains(size)) {
+			return;
+		}
+
 		float scale = stbtt_ScaleForPixelHeight(&m_font_info, (float)size);
 		int ascent;
 		stbtt_GetFontVMetrics(&m_font_info, &ascent, nullptr, nullptr);
 		ascent = (int)std::round(ascent * scale);
-		std::unordered_map<char, Glyph> glyphs;
-		for (char codepoint = ' '; codepoint < '~'; codepoint++) {
-			glyphs[codepoint] = _make_glyph(scale, codepoint);
+		Font& font = m_fonts[size];
+		font.size = size;
+		font.ascent = ascent;
+		font.scale = scale;
+
+		/* Lay out glyphs in atlas */
+		font.atlas_width = 0;
+		int32_t atlas_height = 0;
+		for (int32_t i = 0; i < NUM_GLYPHS; i++) {
+			Glyph& glyph = font.glyphs[i];
+			glyph = _make_glyph(scale, (char)(FIRST_CODEPOINT + i));
+			glyph.atlas_y = atlas_height;
+			font.atlas_width = std::max(font.atlas_width, glyph.width);
+			atlas_height += glyph.height;
+		}
+
+		/* Rasterize glyphs into atlas */
+		font.atlas.resize(font.atlas_width * atlas_height);
+		_point_glyphs_into_atlas(&font);
+		for (int32_t i = 0; i < NUM_GLYPHS; i++) {
+			Glyph& glyph = font.glyphs[i];
+			if (glyph.width > 0 && glyph.height > 0) {
+				stbtt_MakeCodepointBitmap(&m_font_info, font.atlas.data() + glyph.atlas_y * glyph.stride, glyph.width, glyph.height, glyph.stride, scale, scale, FIRST_CODEPOINT + i);
+			}
 		}
-		m_fonts[size] = {
-			.size = size,
-			.ascent = ascent,
-			.scale = scale,
-			.glyphs = std::move(glyphs),
-		};
 	}
 
 	const Glyph& Typeface::glyph(int32_t size, char codepoint) const {
 		const Font& font = _get_font(size);
-		return font.glyphs.at(codepoint);
+		DEBUG_ASSERT(FIRST_CODEPOINT <= codepoint && codepoint <= LAST_CODEPOINT, "Typeface has no glyph for character code %d", codepoint);
+		if (codepoint < FIRST_CODEPOINT || codepoint > LAST_CODEPOINT) {
+			codepoint = '?';
+		}
+		return font.glyphs[codepoint - FIRST_CODEPOINT];
 	}
 
 	int32_t Typeface::ascent(int32_t size) const {
@@ -114,20 +145,24 @@ namespace engine {
 
 		int x0, y0, x1, y1;
 		stbtt_GetCodepointBitmapBox(&m_font_info, codepoint, font_scale, font_scale, &x0, &y0, &x1, &y1);
-		int width = x1 - x0;
-		int height = y1 - y0;
-
-		std::vector<uint8_t> pixels(width * height);
-		stbtt_MakeCodepointBitmap(&m_font_info, pixels.data(), width, height, width, font_scale, font_scale, codepoint);
 
 		return Glyph {
-			.width = width,
-			.height = height,
+			.width = x1 - x0,
+			.height = y1 - y0,
 			.y_offset = y0,
 			.advance_width = advance_width,
 			.left_side_bearing = left_side_bearing,
-			.pixels = pixels,
+			.atlas_y = 0,
+			.stride = 0,
+			.pixels = nullptr,
 		};
 	}
 
+	void Typeface::_point_glyphs_into_atlas(Font* font) {
+		for (Glyph& glyph : font->glyphs) {
+			glyph.stride = font->atlas_width;
+			glyph.pixels = font->atlas.data() + glyph.atlas_y * font->atlas_width;
+		}
+	}
+
 } // namespace engine
@@ -4,6 +4,7 @@
 
 #include <stb_truetype/stb_truetype.h>
 
+#include <array>
 #include <filesystem>
 #include <unordered_map>
 #include <vector>
@@ -18,15 +19,12 @@ namespace engine {
 		int32_t y_offset; // distance from glyph origin to bitmap top
 		int32_t advance_width; // space to insert between this glyph and next
 		int32_t left_side_bearing; // distance from horisontal position to glyph
-		std::vector<uint8_t> pixels; // bitmap data
-
-		inline uint8_t get(int32_t x, int32_t y) const {
-			if (0 <= x && x <= this->width) {
-				if (0 <= y && y <= this->height) {
-					return this->pixels[x + y * this->width];
-				}
-			}
-			return 0;
+		int32_t atlas_y; // first row of bitmap in the atlas of its font
+		int32_t stride; // distance between bitmap rows, the width of the atlas
+		const uint8_t* pixels; // top left of bitmap, points into the atlas
+
+		inline const uint8_t* row(int32_t y) const {
+			return this->pixels + y * this->stride;
 		}
 	};
 
@@ -38,6 +36,11 @@ namespace engine {
 		Typeface(Typeface&& other) noexcept;
 		Typeface& operator=(Typeface&& other) noexcept;
 
+		// Printable ASCII, other characters are drawn as '?'
+		static constexpr char FIRST_CODEPOINT = ' ';
+		static constexpr char LAST_CODEPOINT = '~';
+		static constexpr int32_t NUM_GLYPHS = LAST_CODEPOINT - FIRST_CODEPOINT + 1;
+
 		static std::optional<Typeface> from_path(std::filesystem::path path);
 		void add_font(int32_t size);
 		const Glyph& glyph(int32_t size, char codepoint) const;
@@ -45,15 +48,20 @@ namespace engine {
 		int32_t text_width(int32_t size, const std::string& text) const;
 
 	private:
+		// Glyph bitmaps of a font are stacked top to bottom in one atlas, so
+		// drawing text reads rows out of a single allocation.
 		struct Font {
 			int32_t size;
 			int32_t ascent;
 			float scale;
-			std::unordered_map<char, Glyph> glyphs;
+			std::array<Glyph, NUM_GLYPHS> glyphs; // indexed by codepoint - FIRST_CODEPOINT
+			int32_t atlas_width;
+			std::vector<uint8_t> atlas;
 		};
 
 		const Font& _get_font(int32_t size) const;
 		Glyph _make_glyph(float font_scale, char codepoint) const;
+		static void _point_glyphs_into_atlas(Font* font);
 
 		std::vector<uint8_t> m_file_data;
 		stbtt_fontinfo m_font_info = {};
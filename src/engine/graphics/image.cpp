@@ -2,38 +2,184 @@
 
 #include <engine/math/math.h>
 
+#include <algorithm>
+#include <bit>
 #include <cmath>
+#include <unordered_map>
+#include <utility>
 
 #include <stb_image/stb_image.h>
 
 namespace engine {
 
+	// Images where at least this share of pixels are transparent get run-length encoded
+	constexpr int32_t MIN_TRANSPARENT_PERCENT_FOR_RUNS = 25;
+
+	static void build_runs(Image* image) {
+		image->row_runs.reserve(image->height + 1);
+		for (int32_t y = 0; y < image->height; y++) {
+			image->row_runs.push_back((uint32_t)image->runs.size());
+			const Pixel* row = &image->pixels[y * image->width];
+			for (int32_t x = 0; x < image->width;) {
+				if (row[x].a == 0) {
+					x++;
+					continue;
+				}
+				/* Extend run while pixels need the same kind of blending */
+				const int32_t start = x;
+				const bool is_opaque = row[x].a == 255;
+				while (x < image->width && row[x].a != 0 && (row[x].a == 255) == is_opaque) {
+					x++;
+				}
+				image->runs.push_back(ImageRun {
+					.x = (uint16_t)start,
+					.length = (uint16_t)(x - start),
+					.alpha_mode = is_opaque ? AlphaMode::Opaque : AlphaMode::Blended,
+				});
+			}
+		}
+		image->row_runs.push_back((uint32_t)image->runs.size());
+	}
+
 	Color Image::sample(Vec2 uv) const {
 		int32_t sample_point_x = (int32_t)std::round(uv.x * (this->width - 1));
 		int32_t sample_point_y = (int32_t)std::round((1.0f - uv.y) * (this->height - 1));
-		return this->pixels[sample_point_x + sample_point_y * this->width];
+		return this->pixels[sample_point_x + sample_point_y * this->width].unpremultiplied();
 	}
 
 	Color Image::get(int x, int y) const {
+		return get_premultiplied(x, y).unpremultiplied();
+	}
+
+	Pixel Image::get_premultiplied(int x, int y) const {
 		int32_t clamped_x = engine::clamp(x, 0, this->width - 1);
 		int32_t clamped_y = engine::clamp(y, 0, this->height - 1);
 		return this->pixels[clamped_x + clamped_y * this->width];
 	}
 
-	std::optional<Image> Image::from_path(std::filesystem::path path) {
+	uint8_t Image::get_index(int x, int y) const {
+		int32_t clamped_x = engine::clamp(x, 0, this->width - 1);
+		int32_t clamped_y = engine::clamp(y, 0, this->height - 1);
+		return this->indices[clamped_x + clamped_y * this->width];
+	}
+
+	bool Image::is_indexed() const {
+		return !this->indices.empty();
+	}
+
+	bool Image::build_indices() {
+		if (is_indexed()) {
+			return true;
+		}
+		std::unordered_map<uint32_t, uint8_t> color_indices;
+		std::vector<uint8_t> indices;
+		indices.reserve(this->pixels.size());
+		Palette palette;
+		Pixel previous_pixel = {};
+		uint8_t previous_index = 0;
+		for (size_t i = 0; i < this->pixels.size(); i++) {
+			// Neighboring pixels mostly share a color, so skip the lookup for them
+			const Pixel pixel = this->pixels[i];
+			if (i > 0 && pixel == previous_pixel) {
+				indices.push_back(previous_index);
+				continue;
+			}
+			auto [it, inserted] = color_indices.try_emplace(std::bit_cast<uint32_t>(pixel), (uint8_t)palette.size);
+			if (inserted) {
+				if (palette.size == Palette::MAX_COLORS) {
+					return false;
+				}
+				palette.colors[palette.size++] = pixel;
+			}
+			indices.push_back(it->second);
+			previous_pixel = pixel;
+			previous_index = it->second;
+		}
+		this->indices = std::move(indices);
+		this->palette = palette;
+		this->num_indexed_colors = palette.size;
+		return true;
+	}
+
+	bool Image::has_runs() const {
+		return !this->row_runs.empty();
+	}
+
+	std::span<const ImageRun> Image::runs_in_row(int y) const {
+		return std::span<const ImageRun>(this->runs.data() + this->row_runs[y], this->row_runs[y + 1] - this->row_runs[y]);
+	}
+
+	std::vector<Color> Image::to_colors() const {
+		std::vector<Color> colors;
+		colors.reserve(this->pixels.size());
+		for (Pixel pixel : this->pixels) {
+			colors.push_back(pixel.unpremultiplied());
+		}
+		return colors;
+	}
+
+	Image Image::from_colors(int width, int height, const Color* colors) {
+		std::vector<Pixel> pixels;
+		pixels.reserve((size_t)width * height);
+		for (size_t i = 0; i < (size_t)width * height; i++) {
+			pixels.push_back(Pixel::premultiplied(colors[i]));
+		}
+		return Image::from_pixels(width, height, std::move(pixels));
+	}
+
+	Image Image::from_indexed(int width, int height, std::vector<uint8_t> indices, const Palette& palette) {
+		std::vector<Pixel> pixels;
+		pixels.reserve(indices.size());
+		for (uint8_t index : indices) {
+			pixels.push_back(palette.colors[index]);
+		}
+		Image image = Image::from_pixels(width, height, std::move(pixels));
+		image.num_indexed_colors = indices.empty() ? 0 : *std::max_element(indices.begin(), indices.end()) + 1;
+		image.indices = std::move(indices);
+		image.palette = palette;
+		return image;
+	}
+
+	Image Image::from_pixels(int width, int height, std::vector<Pixel> premultiplied_pixels) {
 		Image image;
+		image.width = width;
+		image.height = height;
+		image.pixels = std::move(premultiplied_pixels);
+
+		/* Find out what kind of blending pixels need */
+		bool is_opaque = true;
+		bool is_binary = true;
+		size_t num_transparent = 0;
+		for (Pixel pixel : image.pixels) {
+			is_opaque = is_opaque && pixel.a == 255;
+			is_binary = is_binary && (pixel.a == 0 || pixel.a == 255);
+			num_transparent += pixel.a == 0;
+		}
+		image.alpha_mode = is_opaque ? AlphaMode::Opaque : (is_binary ? AlphaMode::Binary : AlphaMode::Blended);
+
+		/* Run-length encode mostly transparent images */
+		const bool fits_runs = width <= INT16_MAX; // renderer steps through runs in 16.16 fixed point
+		const size_t num_pixels = image.pixels.size();
+		if (fits_runs && num_pixels > 0 && num_transparent * 100 >= num_pixels * MIN_TRANSPARENT_PERCENT_FOR_RUNS) {
+			build_runs(&image);
+		}
 
+		return image;
+	}
+
+	std::optional<Image> Image::from_path(std::filesystem::path path) {
 		/* Load image using STBI */
+		int width = 0;
+		int height = 0;
 		int num_channels = 0;
 		constexpr int num_requested_channels = 4; // RGBA
-		Color* image_data = (Color*)stbi_load((const char*)path.string().c_str(), &image.width, &image.height, &num_channels, num_requested_channels);
+		Color* image_data = (Color*)stbi_load((const char*)path.string().c_str(), &width, &height, &num_channels, num_requested_channels);
 		if (!image_data) {
 			return {};
 		}
-		size_t length = image.width * image.height;
 
-		/* Copy STBI data to our own vector */
-		image.pixels = std::vector<Color>(image_data, image_data + length);
+		/* Convert STBI data to our own format */
+		Image image = Image::from_colors(width, height, image_data);
 		free(image_data);
 
 		return image;
@@ -1,22 +1,56 @@
 #pragma once
 
 #include <engine/graphics/color.h>
+#include <engine/graphics/palette.h>
+#include <engine/graphics/pixel.h>
 #include <engine/math/vec2.h>
 
 #include <filesystem>
 #include <optional>
+#include <span>
 #include <vector>
 
 namespace engine {
 
+	// Horizontal run of visible pixels in an image row
+	struct ImageRun {
+		uint16_t x;
+		uint16_t length;
+		AlphaMode alpha_mode; // Opaque or Blended
+	};
+
+	// Pixels are stored premultiplied by alpha, in the same BGRA layout as
+	// bitmaps, so they can be blended into a bitmap without converting them.
 	struct Image {
 		int width = 0;
 		int height = 0;
-		std::vector<Color> pixels;
+		std::vector<Pixel> pixels;
+		AlphaMode alpha_mode = AlphaMode::Opaque; // cheapest way to blend all of the pixels
+
+		// Run-length encoding of the visible pixels, only built for mostly
+		// transparent images like sprite sheets so blitting can skip the rest.
+		std::vector<ImageRun> runs; // ordered by row, then by x
+		std::vector<uint32_t> row_runs; // index of the first run of each row, and one past the last run
+
+		// 8-bit indexed copy of the pixels, opted into with build_indices() for
+		// images with at most 256 colors so they can be drawn with another palette.
+		std::vector<uint8_t> indices;
+		Palette palette; // colors of indices, in order of first appearance
+		int32_t num_indexed_colors = 0; // one past the highest index, swapped in palettes are read this far
 
+		static Image from_colors(int width, int height, const Color* colors);
+		static Image from_pixels(int width, int height, std::vector<Pixel> premultiplied_pixels);
+		static Image from_indexed(int width, int height, std::vector<uint8_t> indices, const Palette& palette);
 		static std::optional<Image> from_path(std::filesystem::path path);
+		std::vector<Color> to_colors() const;
 		Color sample(Vec2 uv) const;
 		Color get(int x, int y) const;
+		Pixel get_premultiplied(int x, int y) const;
+		uint8_t get_index(int x, int y) const; // clamped like get_premultiplied, only for indexed images
+		bool is_indexed() const;
+		bool build_indices(); // false if the image has more than 256 colors
+		bool has_runs() const;
+		std::span<const ImageRun> runs_in_row(int y) const;
 	};
 
 } // namespace engine
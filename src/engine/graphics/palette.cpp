@@ -0,0 +1,49 @@
+#include <engine/graphics/palette.h>
+
+#include <engine/math/math.h>
+
+namespace engine {
+
+	Palette Palette::from_colors(std::span<const Color> colors) {
+		Palette palette;
+		palette.size = engine::min((int32_t)colors.size(), MAX_COLORS);
+		for (int32_t i = 0; i < palette.size; i++) {
+			palette.colors[i] = Pixel::premultiplied(colors[i]);
+		}
+		return palette;
+	}
+
+	void Palette::set(int32_t index, Color color) {
+		if (index < 0 || index >= MAX_COLORS) {
+			return;
+		}
+		this->colors[index] = Pixel::premultiplied(color);
+		this->size = engine::max(this->size, index + 1);
+	}
+
+	Color Palette::get(int32_t index) const {
+		return this->colors[engine::clamp(index, 0, MAX_COLORS - 1)].unpremultiplied();
+	}
+
+	std::optional<uint8_t> Palette::index_of(Color color) const {
+		const Pixel pixel = Pixel::premultiplied(color);
+		for (int32_t i = 0; i < this->size; i++) {
+			if (this->colors[i] == pixel) {
+				return (uint8_t)i;
+			}
+		}
+		return {};
+	}
+
+	AlphaMode Palette::alpha_mode(int32_t num_colors) const {
+		AlphaMode alpha_mode = AlphaMode::Opaque;
+		for (int32_t i = 0; i < engine::clamp(num_colors, 0, MAX_COLORS); i++) {
+			const uint8_t a = this->colors[i].a;
+			if (a != 255) {
+				alpha_mode = a == 0 ? engine::max(alpha_mode, AlphaMode::Binary) : AlphaMode::Blended;
+			}
+		}
+		return alpha_mode;
+	}
+
+} // namespace engine
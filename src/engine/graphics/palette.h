@@ -0,0 +1,32 @@
+#pragma once
+
+#include <engine/graphics/color.h>
+#include <engine/graphics/pixel.h>
+
+#include <array>
+#include <optional>
+#include <span>
+#include <stdint.h>
+
+namespace engine {
+
+	// Up to 256 colors looked up by the 8-bit indices of an indexed image
+	//
+	// Colors are premultiplied like image pixels. Drawing an indexed image with
+	// another palette swaps its colors (e.g. enemy variants or palette cycling)
+	// without touching its pixels.
+	struct Palette {
+		static constexpr int32_t MAX_COLORS = 256;
+
+		std::array<Pixel, MAX_COLORS> colors = {}; // unused entries are transparent
+		int32_t size = 0;
+
+		static Palette from_colors(std::span<const Color> colors);
+		void set(int32_t index, Color color);
+		Color get(int32_t index) const;
+		std::optional<uint8_t> index_of(Color color) const;
+		AlphaMode alpha_mode(int32_t num_colors) const; // of the first `num_colors` entries, e.g. the ones an image uses
+		bool operator==(const Palette& rhs) const = default;
+	};
+
+} // namespace engine
@@ -0,0 +1,61 @@
+#include <engine/graphics/pixel.h>
+
+#include <engine/math/math.h>
+
+namespace engine {
+
+	Pixel Pixel::from_color(Color color) {
+		return Pixel {
+			.b = color.b,
+			.g = color.g,
+			.r = color.r,
+		};
+	}
+
+	Pixel Pixel::premultiplied(Color color) {
+		auto premultiply = [&](uint32_t channel) { return (uint8_t)((channel * color.a + 127) / 255); };
+		return Pixel {
+			.b = premultiply(color.b),
+			.g = premultiply(color.g),
+			.r = premultiply(color.r),
+			.a = color.a,
+		};
+	}
+
+	Color Pixel::unpremultiplied() const {
+		if (this->a == 0) {
+			return Color { 0, 0, 0, 0 };
+		}
+		auto unpremultiply = [&](uint32_t channel) { return (uint8_t)engine::min<uint32_t>((channel * 255 + this->a / 2) / this->a, 255); };
+		return Color {
+			.r = unpremultiply(this->r),
+			.g = unpremultiply(this->g),
+			.b = unpremultiply(this->b),
+			.a = this->a,
+		};
+	}
+
+	// Tinting scales channels linearly, so it can be applied to premultiplied pixels as is
+	Pixel Pixel::tinted(Color tint) const {
+		const uint32_t t = tint.a;
+		auto tint_channel = [t](uint32_t channel, uint32_t tint_channel) {
+			uint32_t tinted = channel * tint_channel / 255;
+			return (uint8_t)((channel * (255 - t) + tinted * t) / 255);
+		};
+		return Pixel {
+			.b = tint_channel(this->b, tint.b),
+			.g = tint_channel(this->g, tint.g),
+			.r = tint_channel(this->r, tint.r),
+			.a = this->a,
+		};
+	}
+
+	Pixel Pixel::lerp(Pixel rhs, float t) const {
+		return Pixel {
+			.b = (uint8_t)engine::lerp(this->b, rhs.b, t),
+			.g = (uint8_t)engine::lerp(this->g, rhs.g, t),
+			.r = (uint8_t)engine::lerp(this->r, rhs.r, t),
+		};
+	}
+
+} // namespace engine
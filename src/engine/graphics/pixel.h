@@ -0,0 +1,33 @@
+#pragma once
+
+#include <engine/graphics/color.h>
+
+#include <stdint.h>
+
+namespace engine {
+
+	// Win32 endian stuff means RGB is stored as BGR.
+	// For alignment reasons there's also a 4th byte, which bitmaps ignore and
+	// images use to store alpha.
+	struct Pixel {
+		uint8_t b;
+		uint8_t g;
+		uint8_t r;
+		uint8_t a;
+
+		static Pixel from_color(Color color); // drops alpha
+		static Pixel premultiplied(Color color);
+		Color unpremultiplied() const;
+		Pixel tinted(Color tint) const; // integer version of Color::tint, also works on premultiplied pixels
+		bool operator==(const Pixel& rhs) const = default;
+		Pixel lerp(Pixel rhs, float t) const;
+	};
+
+	// How much blending a run of premultiplied pixels needs, from cheapest to most expensive
+	enum class AlphaMode : uint8_t {
+		Opaque, // every alpha is 255, pixels can be copied
+		Binary, // every alpha is 0 or 255, pixels are either copied or skipped
+		Blended,
+	};
+
+} // namespace engine
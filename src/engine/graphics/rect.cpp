@@ -1,5 +1,7 @@
 #include <engine/graphics/rect.h>
 
+#include <engine/math/math.h>
+
 namespace engine {
 
 	Rect operator+(Rect lhs, IVec2 rhs) {
@@ -14,10 +16,26 @@ namespace engine {
 		return Rect { lhs.x, lhs.y, (int32_t)(lhs.width * rhs), (int32_t)(lhs.height * rhs) };
 	}
 
+	Rect Rect::intersection(Rect lhs, Rect rhs) {
+		int32_t left = engine::max(lhs.x, rhs.x);
+		int32_t top = engine::max(lhs.y, rhs.y);
+		int32_t right = engine::min(lhs.x + lhs.width, rhs.x + rhs.width);
+		int32_t bottom = engine::min(lhs.y + lhs.height, rhs.y + rhs.height);
+		return Rect { left, top, engine::max(right - left, 0), engine::max(bottom - top, 0) };
+	}
+
 	bool Rect::empty() const {
 		return this->width == 0 && this->height == 0;
 	}
 
+	bool Rect::has_area() const {
+		return this->width > 0 && this->height > 0;
+	}
+
+	bool Rect::contains(IVec2 point) const {
+		return this->x <= point.x && point.x < this->x + this->width && this->y <= point.y && point.y < this->y + this->height;
+	}
+
 	IVec2 Rect::pos() const {
 		return IVec2 { this->x, this->y };
 	}
@@ -20,7 +20,11 @@ namespace engine {
 		friend Rect operator-(Rect lhs, IVec2 rhs); // translate position
 		friend Rect operator*(Rect lhs, float rhs); // scale relative top left corner
 
+		static Rect intersection(Rect lhs, Rect rhs); // zero area if not overlapping
+
 		bool empty() const;
+		bool has_area() const;
+		bool contains(IVec2 point) const;
 		IVec2 pos() const;
 	};
 
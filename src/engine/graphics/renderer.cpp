@@ -1,22 +1,1265 @@
 #include <engine/graphics/renderer.h>
 
-#include <engine/container/match_variant.h>
+#include <engine/debug/assert.h>
 #include <engine/debug/profiling.h>
 #include <engine/file/resource_manager.h>
 #include <engine/graphics/font.h>
 #include <engine/graphics/image.h>
+#include <engine/graphics/palette.h>
 #include <engine/graphics/rect.h>
+#include <engine/graphics/tilemap.h>
 #include <engine/math/math.h>
-#include <engine/utility/string_utility.h>
 
 #include <engine/debug/logging.h>
 
+#include <algorithm>
+#include <array>
+#include <atomic>
+#include <bit>
 #include <cmath>
+#include <span>
+#include <thread>
+#include <type_traits>
 #include <utility>
 
+#if defined(__AVX2__) || defined(_M_X64) || defined(__SSE2__)
+#include <immintrin.h>
+#endif
+
 namespace engine {
 
-	static std::vector<IVec2> circle_octant_points(int32_t radius) {
+	constexpr int32_t TILE_SIZE = 32;
+	constexpr int32_t MAX_CACHED_CIRCLE_RADIUS = 256;
+	constexpr size_t INVALID_TILE_HASH = 0; // never produced by hashing, forces a tile to be redrawn
+	constexpr int64_t MAX_UNDRAWN_TILEMAP_CHUNK_FRAMES = 60; // chunks and scroll buffers off-screen for longer are freed
+	constexpr int32_t MAX_OCCLUDERS = 8; // largest opaque rects kept while culling hidden commands
+
+	// Render targets get negative image ids, so they never clash with loaded images
+	static bool is_render_target(ImageID image_id) {
+		return image_id.value < 0;
+	}
+
+	static size_t render_target_index(ImageID image_id) {
+		return (size_t)(-image_id.value - 1);
+	}
+
+	static ImageID render_target_id(size_t index) {
+		return ImageID(-(int)index - 1);
+	}
+
+	// Applies tint and then alpha to a premultiplied pixel
+	template <bool is_tinted, bool is_translucent>
+	static inline Pixel shade_pixel(Pixel pixel, Color tint, const uint8_t* alpha_table) {
+		if constexpr (is_tinted) {
+			pixel = pixel.tinted(tint);
+		}
+		if constexpr (is_translucent) {
+			pixel = Pixel { alpha_table[pixel.b], alpha_table[pixel.g], alpha_table[pixel.r], alpha_table[pixel.a] };
+		}
+		return pixel;
+	}
+
+	/* Pixel kernels */
+	// Kernels are templates over the draw state below, so their inner loops
+	// don't branch on it. A command picks its kernel once, by indexing a
+	// table of instantiations with its state key.
+	enum ImageKernelFlags : uint8_t {
+		IMAGE_KERNEL_TINTED = 1 << 0,
+		IMAGE_KERNEL_TRANSLUCENT = 1 << 1,
+		IMAGE_KERNEL_FLIPPED = 1 << 2, // walks the source row backwards
+		IMAGE_KERNEL_CLAMPED = 1 << 3, // clamps source columns to the row, for clip rects reaching outside the image
+		IMAGE_KERNEL_COUNT = 1 << 4,
+	};
+
+	static uint8_t image_kernel_key(bool is_tinted, bool is_translucent, bool is_flipped, bool is_clamped) {
+		return (is_tinted ? IMAGE_KERNEL_TINTED : 0)
+			| (is_translucent ? IMAGE_KERNEL_TRANSLUCENT : 0)
+			| (is_flipped ? IMAGE_KERNEL_FLIPPED : 0)
+			| (is_clamped ? IMAGE_KERNEL_CLAMPED : 0);
+	}
+
+	// Gathers `length` pixels from `src_row`, one column at a time starting at
+	// `src_x`, with tint and alpha applied.
+	template <uint8_t key>
+	static void shade_image_row(const Pixel* src_row, int32_t row_width, int32_t src_x, int32_t length, Color tint, const uint8_t* alpha_table, Pixel* pixels) {
+		constexpr bool is_tinted = key & IMAGE_KERNEL_TINTED;
+		constexpr bool is_translucent = key & IMAGE_KERNEL_TRANSLUCENT;
+		constexpr int32_t step = (key & IMAGE_KERNEL_FLIPPED) ? -1 : 1;
+		for (int32_t i = 0; i < length; i++) {
+			int32_t x = src_x + i * step;
+			if constexpr (key & IMAGE_KERNEL_CLAMPED) {
+				x = engine::clamp(x, 0, row_width - 1);
+			}
+			pixels[i] = shade_pixel<is_tinted, is_translucent>(src_row[x], tint, alpha_table);
+		}
+	}
+
+	// Gathers `length` pixels from `src_row`, stepping through it in 16.16 fixed point
+	// starting at `src_x`, with tint and alpha applied. Flips are negative steps, so
+	// only the tint and alpha bits of the key are used.
+	template <uint8_t key>
+	static void scale_image_row(const Pixel* src_row, int32_t src_x, int32_t src_step, int32_t length, Color tint, const uint8_t* alpha_table, Pixel* pixels) {
+		constexpr bool is_tinted = key & IMAGE_KERNEL_TINTED;
+		constexpr bool is_translucent = key & IMAGE_KERNEL_TRANSLUCENT;
+		for (int32_t i = 0; i < length; i++) {
+			pixels[i] = shade_pixel<is_tinted, is_translucent>(src_row[src_x >> 16], tint, alpha_table);
+			src_x += src_step;
+		}
+	}
+
+	using ShadeImageRow = void (*)(const Pixel*, int32_t, int32_t, int32_t, Color, const uint8_t*, Pixel*);
+	using ScaleImageRow = void (*)(const Pixel*, int32_t, int32_t, int32_t, Color, const uint8_t*, Pixel*);
+
+	template <size_t... keys>
+	static constexpr std::array<ShadeImageRow, sizeof...(keys)> shade_image_row_kernels(std::index_sequence<keys...>) {
+		return { &shade_image_row<keys>... };
+	}
+
+	template <size_t... keys>
+	static constexpr std::array<ScaleImageRow, sizeof...(keys)> scale_image_row_kernels(std::index_sequence<keys...>) {
+		return { &scale_image_row<keys>... };
+	}
+
+	static constexpr std::array<ShadeImageRow, IMAGE_KERNEL_COUNT> SHADE_IMAGE_ROW_KERNELS = shade_image_row_kernels(std::make_index_sequence<IMAGE_KERNEL_COUNT>());
+	static constexpr std::array<ScaleImageRow, IMAGE_KERNEL_FLIPPED> SCALE_IMAGE_ROW_KERNELS = scale_image_row_kernels(std::make_index_sequence<IMAGE_KERNEL_FLIPPED>());
+
+	static void fill_alpha_table(float alpha, uint8_t* alpha_table) {
+		for (int32_t i = 0; i < 256; i++) {
+			alpha_table[i] = (uint8_t)engine::clamp(std::round(i * alpha), 0.0f, 255.0f);
+		}
+	}
+
+	// Applies tint and alpha to palette colors once, so indexed pixels only need a lookup
+	// The alpha mode covers the colors `image` uses, which can go past the palette's size.
+	static AlphaMode shade_palette(const Palette& palette, const Image& image, Color tint, float alpha, Pixel* shaded_colors) {
+		const bool is_tinted = tint.a > 0 && tint != Color::white();
+		const bool is_translucent = alpha != 1.0f;
+		uint8_t alpha_table[256];
+		if (is_translucent) {
+			fill_alpha_table(alpha, alpha_table);
+		}
+		for (int32_t i = 0; i < Palette::MAX_COLORS; i++) {
+			Pixel pixel = palette.colors[i];
+			if (is_tinted) {
+				pixel = pixel.tinted(tint);
+			}
+			if (is_translucent) {
+				pixel = Pixel { alpha_table[pixel.b], alpha_table[pixel.g], alpha_table[pixel.r], alpha_table[pixel.a] };
+			}
+			shaded_colors[i] = pixel;
+		}
+		return is_translucent ? AlphaMode::Blended : palette.alpha_mode(image.num_indexed_colors);
+	}
+
+	// Blends laid out glyphs in a single color, specialized on whether the
+	// color is opaque so glyph coverage can be blended as is
+	template <bool is_opaque>
+	static void put_glyph_rows(Bitmap* bitmap, Rect clip, const TextLayout& layout, IVec2 pos, Color color) {
+		const Pixel pixel = Pixel::from_color(color);
+
+		// glyph coverage scaled by color alpha
+		constexpr int32_t CHUNK_SIZE = 64;
+		uint8_t alphas[CHUNK_SIZE];
+
+		for (const TextLayout::Row& row : layout.rows) {
+			// Tiles only overlap a few rows of a text box
+			if (pos.y + row.bottom <= clip.y || pos.y + row.top >= clip.y + clip.height) {
+				continue;
+			}
+			for (uint32_t glyph_index = row.first_glyph; glyph_index < row.end_glyph; glyph_index++) {
+				const TextLayout::PositionedGlyph& positioned_glyph = layout.glyphs[glyph_index];
+				const Glyph& glyph = *positioned_glyph.glyph;
+				const Rect glyph_rect = {
+					.x = pos.x + positioned_glyph.pos.x,
+					.y = pos.y + positioned_glyph.pos.y,
+					.width = glyph.width,
+					.height = glyph.height,
+				};
+				const Rect clipped_rect = Rect::intersection(glyph_rect, clip);
+				for (int32_t y = clipped_rect.y; y < clipped_rect.y + clipped_rect.height; y++) {
+					const uint8_t* coverage = glyph.row(y - glyph_rect.y) + (clipped_rect.x - glyph_rect.x);
+					if constexpr (is_opaque) {
+						bitmap->blend_span(clipped_rect.x, y, clipped_rect.width, pixel, coverage);
+						continue;
+					}
+					for (int32_t chunk_x = 0; chunk_x < clipped_rect.width; chunk_x += CHUNK_SIZE) {
+						int32_t chunk_length = engine::min(CHUNK_SIZE, clipped_rect.width - chunk_x);
+						for (int32_t i = 0; i < chunk_length; i++) {
+							alphas[i] = (uint8_t)((coverage[chunk_x + i] * color.a + 127) / 255);
+						}
+						bitmap->blend_span(clipped_rect.x + chunk_x, y, chunk_length, pixel, alphas);
+					}
+				}
+			}
+		}
+	}
+
+	using PutGlyphs = void (*)(Bitmap*, Rect, const TextLayout&, IVec2, Color);
+
+	// Blits a clip of a sprite sheet the same way Renderer::_put_image() does,
+	// minus tint, palette and clamping. `src_rect` has to lie inside of `image`,
+	// and `alpha_table` has to be filled in for translucent instances.
+	static void put_sprite(Bitmap* bitmap, Rect clip, const Image& image, Rect src_rect, const SpriteInstance& instance, const uint8_t* alpha_table) {
+		const Rect dst_rect = Rect::intersection(Rect { instance.pos.x, instance.pos.y, src_rect.width, src_rect.height }, clip);
+		if (!dst_rect.has_area()) {
+			return;
+		}
+
+		/* Source texel of the top left destination pixel */
+		const bool flip_h = instance.flags & SPRITE_FLIP_H;
+		const bool flip_v = instance.flags & SPRITE_FLIP_V;
+		const int32_t src_step_y = flip_v ? -1 : 1;
+		const IVec2 src_start = {
+			src_rect.x + (flip_h ? instance.pos.x + src_rect.width - 1 - dst_rect.x : dst_rect.x - instance.pos.x),
+			src_rect.y + (flip_v ? instance.pos.y + src_rect.height - 1 - dst_rect.y : dst_rect.y - instance.pos.y),
+		};
+		const bool is_translucent = instance.alpha != 255;
+		const ShadeImageRow shade_row = SHADE_IMAGE_ROW_KERNELS[image_kernel_key(false, true, flip_h, false)];
+		constexpr int32_t CHUNK_SIZE = 64;
+		Pixel pixels[CHUNK_SIZE];
+
+		/* Run-length encoded path, only visit visible pixels */
+		if (image.has_runs()) {
+			const int32_t src_x_min = flip_h ? src_start.x - dst_rect.width + 1 : src_start.x;
+			const int32_t src_x_max = src_x_min + dst_rect.width;
+			for (int32_t y = 0; y < dst_rect.height; y++) {
+				const int32_t src_y = src_start.y + y * src_step_y;
+				const Pixel* src_row = &image.pixels[src_y * image.width];
+				std::span<const ImageRun> runs = image.runs_in_row(src_y);
+				auto run = std::partition_point(runs.begin(), runs.end(), [&](const ImageRun& candidate) { return candidate.x + candidate.length <= src_x_min; });
+				for (; run != runs.end() && run->x < src_x_max; ++run) {
+					const int32_t start = engine::max<int32_t>(run->x, src_x_min);
+					const int32_t end = engine::min<int32_t>(run->x + run->length, src_x_max);
+					const int32_t dst_x = flip_h ? dst_rect.x + src_start.x - (end - 1) : dst_rect.x + start - src_start.x;
+					if (!is_translucent) {
+						const Pixel* src_pixels = flip_h ? src_row + end - 1 : src_row + start;
+						bitmap->blend_span(dst_x, dst_rect.y + y, end - start, src_pixels, run->alpha_mode, flip_h);
+						continue;
+					}
+					for (int32_t chunk_x = 0; chunk_x < end - start; chunk_x += CHUNK_SIZE) {
+						const int32_t chunk_length = engine::min(CHUNK_SIZE, end - start - chunk_x);
+						const int32_t src_x = flip_h ? end - 1 - chunk_x : start + chunk_x;
+						shade_row(src_row, image.width, src_x, chunk_length, Color::white(), alpha_table, pixels);
+						bitmap->blend_span(dst_x + chunk_x, dst_rect.y + y, chunk_length, pixels, AlphaMode::Blended, false);
+					}
+				}
+			}
+			return;
+		}
+
+		/* Blend opaque rows as is */
+		if (!is_translucent) {
+			for (int32_t y = 0; y < dst_rect.height; y++) {
+				const Pixel* src_row = &image.pixels[src_start.x + (src_start.y + y * src_step_y) * image.width];
+				bitmap->blend_span(dst_rect.x, dst_rect.y + y, dst_rect.width, src_row, image.alpha_mode, flip_h);
+			}
+			return;
+		}
+
+		/* Shade translucent rows in chunks */
+		for (int32_t y = 0; y < dst_rect.height; y++) {
+			const Pixel* src_row = &image.pixels[(src_start.y + y * src_step_y) * image.width];
+			for (int32_t chunk_x = 0; chunk_x < dst_rect.width; chunk_x += CHUNK_SIZE) {
+				const int32_t chunk_length = engine::min(CHUNK_SIZE, dst_rect.width - chunk_x);
+				shade_row(src_row, image.width, src_start.x + (flip_h ? -chunk_x : chunk_x), chunk_length, Color::white(), alpha_table, pixels);
+				bitmap->blend_span(dst_rect.x + chunk_x, dst_rect.y + y, chunk_length, pixels, AlphaMode::Blended, false);
+			}
+		}
+	}
+
+	// Integer division rounding towards negative infinity, `denominator` must be positive
+	static int64_t floor_div(int64_t numerator, int64_t denominator) {
+		int64_t quotient = numerator / denominator;
+		return (numerator % denominator != 0 && numerator < 0) ? quotient - 1 : quotient;
+	}
+
+	/* Line kernels */
+	enum class LineShading : uint8_t {
+		Solid, // both vertices have the same color
+		Gradient,
+		Textured,
+	};
+
+	// Outcode of a point, see Cohen-Sutherland line clipping
+	enum LineOutcode : uint8_t {
+		OUTCODE_LEFT = 1 << 0,
+		OUTCODE_RIGHT = 1 << 1,
+		OUTCODE_TOP = 1 << 2,
+		OUTCODE_BOTTOM = 1 << 3,
+	};
+
+	static uint8_t line_outcode(double x, double y, double left, double top, double right, double bottom) {
+		return (x < left ? OUTCODE_LEFT : 0)
+			| (x > right ? OUTCODE_RIGHT : 0)
+			| (y < top ? OUTCODE_TOP : 0)
+			| (y > bottom ? OUTCODE_BOTTOM : 0);
+	}
+
+	// First and last step along the major axis of the line from `p1` to `p2`
+	// that can put a point inside of `clip`, empty if none can.
+	//
+	// The line is clipped with Cohen-Sutherland against the clip rect grown by
+	// a pixel, since Bresenham puts points up to half a pixel off the line.
+	static std::optional<std::pair<int32_t, int32_t>> visible_line_steps(IVec2 p1, IVec2 p2, Rect clip) {
+		const double left = clip.x - 1.0;
+		const double top = clip.y - 1.0;
+		const double right = clip.x + clip.width;
+		const double bottom = clip.y + clip.height;
+		double x1 = p1.x, y1 = p1.y, x2 = p2.x, y2 = p2.y;
+		uint8_t outcode1 = line_outcode(x1, y1, left, top, right, bottom);
+		uint8_t outcode2 = line_outcode(x2, y2, left, top, right, bottom);
+		while (outcode1 | outcode2) {
+			if (outcode1 & outcode2) {
+				return {};
+			}
+			/* Move an outside end point onto the clip edge it's outside of */
+			const uint8_t outcode = outcode1 ? outcode1 : outcode2;
+			double x, y;
+			if (outcode & OUTCODE_TOP) {
+				x = x1 + (x2 - x1) * (top - y1) / (y2 - y1);
+				y = top;
+			}
+			else if (outcode & OUTCODE_BOTTOM) {
+				x = x1 + (x2 - x1) * (bottom - y1) / (y2 - y1);
+				y = bottom;
+			}
+			else if (outcode & OUTCODE_RIGHT) {
+				y = y1 + (y2 - y1) * (right - x1) / (x2 - x1);
+				x = right;
+			}
+			else {
+				y = y1 + (y2 - y1) * (left - x1) / (x2 - x1);
+				x = left;
+			}
+			if (outcode == outcode1) {
+				x1 = x;
+				y1 = y;
+				outcode1 = line_outcode(x1, y1, left, top, right, bottom);
+			}
+			else {
+				x2 = x;
+				y2 = y;
+				outcode2 = line_outcode(x2, y2, left, top, right, bottom);
+			}
+		}
+
+		/* Measure clipped end points in steps from p1, with a step of slack */
+		const bool is_x_major = std::abs(p2.x - p1.x) >= std::abs(p2.y - p1.y);
+		const int32_t num_steps = is_x_major ? std::abs(p2.x - p1.x) : std::abs(p2.y - p1.y);
+		auto to_step = [&](double x, double y) { return is_x_major ? std::abs(x - p1.x) : std::abs(y - p1.y); };
+		const double step1 = to_step(x1, y1);
+		const double step2 = to_step(x2, y2);
+		const int32_t first_step = engine::clamp((int32_t)std::floor(engine::min(step1, step2)) - 1, 0, num_steps);
+		const int32_t last_step = engine::clamp((int32_t)std::ceil(engine::max(step1, step2)) + 1, 0, num_steps);
+		return std::pair { first_step, last_step };
+	}
+
+	// Puts the points of a line from `first_step` to `last_step` along its major
+	// axis, specialized on shading and on whether the points need clipping
+	//
+	// Bresenham's drawing algorithm
+	// Alois Zingl, 2016, "A Rasterizing Algorithm for Drawing Curves", page 13
+	// https://zingl.github.io/Bresenham.pdf
+	template <LineShading shading, bool is_inside_clip>
+	static void put_line_points(Bitmap* bitmap, Rect clip, Vertex v1, Vertex v2, const Image* image, int32_t first_step, int32_t last_step) {
+		const int32_t delta_x = std::abs(v2.pos.x - v1.pos.x);
+		const int32_t delta_y = -std::abs(v2.pos.y - v1.pos.y);
+		const int32_t sign_x = v1.pos.x < v2.pos.x ? 1 : -1;
+		const int32_t sign_y = v1.pos.y < v2.pos.y ? 1 : -1;
+
+		/* Jump to first step */
+		// Every step moves one pixel along the major axis, and the minor axis
+		// has moved by the number of times the error crossed half a pixel
+		IVec2 offset = { 0, 0 };
+		if (first_step > 0) {
+			const int64_t step = first_step;
+			if (delta_x >= -delta_y) {
+				offset.x = first_step;
+				offset.y = (int32_t)engine::min(step, floor_div(2 * (step + 1) * -delta_y - delta_x, 2 * (int64_t)delta_x) + 1);
+			}
+			else {
+				offset.y = first_step;
+				offset.x = (int32_t)engine::min(step, floor_div(2 * step * delta_x + delta_y, 2 * (int64_t)-delta_y) + 1);
+			}
+		}
+		int32_t error = delta_x + delta_y + offset.x * delta_y + offset.y * delta_x;
+
+		const Pixel solid_pixel = Pixel::from_color(v1.color);
+		const float solid_alpha = v1.color.a / 255.0f;
+		Vertex cursor = v1;
+		cursor.pos = v1.pos + IVec2 { offset.x * sign_x, offset.y * sign_y };
+		for (int32_t step = first_step; step <= last_step; step++) {
+			/* Put current point */
+			if (is_inside_clip || clip.contains(cursor.pos)) {
+				if constexpr (shading == LineShading::Solid) {
+					bitmap->put(cursor.pos.x, cursor.pos.y, solid_pixel, solid_alpha);
+				}
+				else {
+					float t = delta_x > 0
+						? ((float)(cursor.pos.x - v1.pos.x) / (float)(v2.pos.x - v1.pos.x))
+						: ((float)(cursor.pos.y - v1.pos.y) / (float)(v2.pos.y - v1.pos.y));
+					if constexpr (shading == LineShading::Textured) {
+						cursor.color = image->sample(Vec2::lerp(v1.uv, v2.uv, t)) * Color::lerp(v1.color, v2.color, t);
+					}
+					else {
+						cursor.color = Color::lerp(v1.color, v2.color, t);
+					}
+					bitmap->put(cursor.pos.x, cursor.pos.y, Pixel::from_color(cursor.color), cursor.color.a / 255.0f);
+				}
+			}
+
+			/* Step to next point */
+			if (2 * error >= delta_y) {
+				if (cursor.pos.x == v2.pos.x) {
+					break;
+				}
+				error += delta_y;
+				cursor.pos.x += sign_x;
+			}
+			if (2 * error <= delta_x) {
+				if (cursor.pos.y == v2.pos.y) {
+					break;
+				}
+				error += delta_x;
+				cursor.pos.y += sign_y;
+			}
+		}
+	}
+
+	using PutLinePoints = void (*)(Bitmap*, Rect, Vertex, Vertex, const Image*, int32_t, int32_t);
+	static constexpr PutLinePoints LINE_KERNELS[3][2] = {
+		{ &put_line_points<LineShading::Solid, false>, &put_line_points<LineShading::Solid, true> },
+		{ &put_line_points<LineShading::Gradient, false>, &put_line_points<LineShading::Gradient, true> },
+		{ &put_line_points<LineShading::Textured, false>, &put_line_points<LineShading::Textured, true> },
+	};
+
+	// Edge function of the line from `a` to `b`, positive to the right of
+	// the line when y points down, evaluated at integer pixel centers.
+	struct TriangleEdge {
+		IVec2 origin;
+		int32_t step_x; // change per pixel in x
+		int32_t step_y; // change per pixel in y
+		int32_t bias; // makes pixels exactly on the edge count only for top and left edges
+
+		static TriangleEdge between(IVec2 a, IVec2 b) {
+			TriangleEdge edge = {
+				.origin = a,
+				.step_x = a.y - b.y,
+				.step_y = b.x - a.x,
+			};
+			const bool is_left_edge = edge.step_x > 0;
+			const bool is_top_edge = edge.step_x == 0 && edge.step_y > 0;
+			edge.bias = is_left_edge || is_top_edge ? 0 : -1;
+			return edge;
+		}
+
+		int64_t evaluate(IVec2 point) const {
+			return (int64_t)step_x * (point.x - origin.x) + (int64_t)step_y * (point.y - origin.y);
+		}
+	};
+
+	// Writes `length` colors, stepping 16.16 fixed point RGBA channel `values` by `steps` per color
+	static void interpolate_colors(const int64_t* values, const int64_t* steps, int32_t length, Color* colors) {
+#if defined(__AVX2__) || defined(_M_X64) || defined(__SSE2__)
+		// Channels of pixels inside a triangle fit in 32 bits, and a step
+		// can only overflow if there's no next pixel inside it.
+		auto to_int32 = [](int64_t x) { return (int32_t)engine::clamp<int64_t>(x, INT32_MIN, INT32_MAX); };
+		__m128i channels = _mm_setr_epi32(to_int32(values[0]), to_int32(values[1]), to_int32(values[2]), to_int32(values[3]));
+		const __m128i channel_steps = _mm_setr_epi32(to_int32(steps[0]), to_int32(steps[1]), to_int32(steps[2]), to_int32(steps[3]));
+		for (int32_t i = 0; i < length; i++) {
+			__m128i bytes = _mm_srai_epi32(channels, 16);
+			bytes = _mm_packs_epi32(bytes, bytes);
+			bytes = _mm_packus_epi16(bytes, bytes);
+			colors[i] = std::bit_cast<Color>(_mm_cvtsi128_si32(bytes));
+			channels = _mm_add_epi32(channels, channel_steps);
+		}
+#else
+		for (int32_t i = 0; i < length; i++) {
+			auto channel = [&](int32_t c) { return (uint8_t)engine::clamp<int64_t>((values[c] + i * steps[c]) >> 16, 0, 255); };
+			colors[i] = Color { .r = channel(0), .g = channel(1), .b = channel(2), .a = channel(3) };
+		}
+#endif
+	}
+
+	static Rect bounding_rect(std::initializer_list<IVec2> points) {
+		IVec2 top_left = *points.begin();
+		IVec2 bottom_right = *points.begin();
+		for (IVec2 point : points) {
+			top_left = { engine::min(top_left.x, point.x), engine::min(top_left.y, point.y) };
+			bottom_right = { engine::max(bottom_right.x, point.x), engine::max(bottom_right.y, point.y) };
+		}
+		return Rect { top_left.x, top_left.y, bottom_right.x - top_left.x + 1, bottom_right.y - top_left.y + 1 };
+	}
+
+	static Rect vertex_bounds(std::span<const Vertex> vertices) {
+		IVec2 top_left = vertices[0].pos;
+		IVec2 bottom_right = vertices[0].pos;
+		for (const Vertex& vertex : vertices) {
+			top_left = { engine::min(top_left.x, vertex.pos.x), engine::min(top_left.y, vertex.pos.y) };
+			bottom_right = { engine::max(bottom_right.x, vertex.pos.x), engine::max(bottom_right.y, vertex.pos.y) };
+		}
+		return Rect { top_left.x, top_left.y, bottom_right.x - top_left.x + 1, bottom_right.y - top_left.y + 1 };
+	}
+
+	// Part of `rect` not covered by `occluder`, if that part is a rect itself.
+	// Otherwise all of `rect`.
+	static Rect uncovered_rect(Rect rect, Rect occluder) {
+		const Rect overlap = Rect::intersection(rect, occluder);
+		if (!overlap.has_area()) {
+			return rect;
+		}
+		const int32_t right = rect.x + rect.width;
+		const int32_t bottom = rect.y + rect.height;
+		const int32_t overlap_right = overlap.x + overlap.width;
+		const int32_t overlap_bottom = overlap.y + overlap.height;
+		if (overlap.x == rect.x && overlap_right == right) {
+			if (overlap.y == rect.y) {
+				return Rect { rect.x, overlap_bottom, rect.width, bottom - overlap_bottom };
+			}
+			if (overlap_bottom == bottom) {
+				return Rect { rect.x, rect.y, rect.width, overlap.y - rect.y };
+			}
+		}
+		if (overlap.y == rect.y && overlap_bottom == bottom) {
+			if (overlap.x == rect.x) {
+				return Rect { overlap_right, rect.y, right - overlap_right, rect.height };
+			}
+			if (overlap_right == right) {
+				return Rect { rect.x, rect.y, overlap.x - rect.x, rect.height };
+			}
+		}
+		return rect;
+	}
+
+	// Folds the fields of a draw command into a hash, see boost::hash_combine
+	struct CommandHasher {
+		size_t hash = 0;
+
+		template <typename T>
+		void add(const T& value) {
+			hash ^= std::hash<T>()(value) + 0x9e3779b9 + (hash << 6) + (hash >> 2);
+		}
+		void add(Color color) {
+			add(std::bit_cast<uint32_t>(color));
+		}
+		void add(Rect rect) {
+			add(rect.x);
+			add(rect.y);
+			add(rect.width);
+			add(rect.height);
+		}
+		void add(const Vertex& vertex) {
+			add(vertex.pos);
+			add(vertex.color);
+			add(vertex.uv);
+		}
+		void add(const SpriteInstance& instance) {
+			add(instance.pos);
+			add(instance.clip_index);
+			add(instance.flags);
+			add(instance.alpha);
+		}
+		void add(const DrawImageOptions& options) {
+			add(options.clip);
+			add(options.flip_h);
+			add(options.flip_v);
+			add(options.alpha);
+			add(options.tint);
+			if (options.palette) {
+				for (int32_t i = 0; i < options.palette->size; i++) {
+					add(std::bit_cast<uint32_t>(options.palette->colors[i]));
+				}
+			}
+		}
+		void add(const DrawTextOptions& options) {
+			add(options.h_alignment);
+			add(options.debug_draw_box);
+		}
+	};
+
+	// Layer in the top bits, then depth, then batch. Sign bits are flipped so
+	// that negative layers and depths sort first.
+	// Batch of draws from an image, 0 is left for commands that aren't batched.
+	// Render targets have negative ids, so they're given their own range.
+	static uint32_t image_batch(ImageID image_id) {
+		if (is_render_target(image_id)) {
+			return 0x80000000u | (uint32_t)render_target_index(image_id);
+		}
+		return (uint32_t)image_id.value;
+	}
+
+	static uint64_t draw_order_key(int16_t layer, int16_t depth, uint32_t batch) {
+		const uint64_t biased_layer = (uint16_t)layer ^ 0x8000u;
+		const uint64_t biased_depth = (uint16_t)depth ^ 0x8000u;
+		return (biased_layer << 48) | (biased_depth << 32) | batch;
+	}
+
+	Renderer Renderer::with_bitmap(int32_t width, int32_t height) {
+		Renderer renderer;
+		renderer.m_bitmap = Bitmap::with_size(width, height);
+		return renderer;
+	}
+
+	void Renderer::add_tag(std::string_view tag) {
+#ifdef TRACY_ENABLE
+		m_current_tag = m_command_arena.push_string(tag);
+#endif
+	}
+
+	void Renderer::set_draw_layer(int16_t layer) {
+		m_draw_layer = layer;
+		m_draw_depth.reset();
+	}
+
+	void Renderer::set_draw_layer(int16_t layer, int16_t depth) {
+		m_draw_layer = layer;
+		m_draw_depth = depth;
+	}
+
+	void Renderer::push_clip_rect(Rect rect) {
+		const Rect enclosing = m_clip_rects.empty() ? _target_rect() : m_clip_rects.back();
+		m_clip_rects.push_back(Rect::intersection(rect, enclosing));
+	}
+
+	void Renderer::pop_clip_rect() {
+		DEBUG_ASSERT(!m_clip_rects.empty(), "pop_clip_rect() without matching push_clip_rect()");
+		if (!m_clip_rects.empty()) {
+			m_clip_rects.pop_back();
+		}
+	}
+
+	ImageID Renderer::create_render_target(int32_t width, int32_t height) {
+		RenderTarget target = {
+			.bitmap = Bitmap::with_size(width, height),
+			.version = 0,
+		};
+		target.image = target.bitmap.to_image();
+		m_render_targets.push_back(std::move(target));
+		return render_target_id(m_render_targets.size() - 1);
+	}
+
+	void Renderer::begin_render_target(ImageID target) {
+		DEBUG_ASSERT(is_render_target(target) && render_target_index(target) < m_render_targets.size(), "Trying to draw into non-existing render target using id %d", target.value);
+		DEBUG_ASSERT(!m_active_render_target, "Render targets can't be nested");
+		DEBUG_ASSERT(m_clip_rects.empty(), "Render targets can't be begun inside of a clip rect");
+		m_active_render_target = render_target_index(target);
+	}
+
+	void Renderer::end_render_target() {
+		DEBUG_ASSERT(m_active_render_target, "end_render_target() without matching begin_render_target()");
+		DEBUG_ASSERT(m_clip_rects.empty(), "push_clip_rect() without matching pop_clip_rect()");
+		m_active_render_target.reset();
+	}
+
+	void Renderer::set_tiled_rendering(bool enabled, int32_t num_threads) {
+		m_tiled_rendering = enabled;
+		m_num_render_threads = num_threads;
+	}
+
+	void Renderer::HOT_RELOAD_stop_render_threads() {
+		if (m_render_threads) {
+			m_render_threads->stop();
+		}
+	}
+
+	void Renderer::set_dirty_rect_tracking(bool enabled) {
+		m_dirty_rect_tracking = enabled;
+		m_tile_hashes.clear();
+	}
+
+	void Renderer::set_debug_draw_dirty_rects(bool enabled) {
+		m_debug_draw_dirty_rects = enabled;
+	}
+
+	void Renderer::set_frame_skipping(bool enabled) {
+		m_frame_skipping = enabled;
+		m_frame_hash.reset();
+		for (RenderTarget& target : m_render_targets) {
+			target.commands_hash.reset();
+		}
+	}
+
+	void Renderer::set_transformed_image_budget(size_t bytes) {
+		m_transformed_images.set_budget(bytes);
+	}
+
+	void Renderer::clear_screen(Color color) {
+		_push_command(ClearScreen { color });
+	}
+
+	void Renderer::draw_point(Vertex v1) {
+		_push_command(DrawPoint { v1 });
+	}
+
+	void Renderer::draw_line(Vertex v1, Vertex v2) {
+		_push_command(DrawLine { v1, v2 });
+	}
+
+	void Renderer::draw_line(IVec2 pos1, IVec2 pos2, Color color) {
+		_push_command(DrawLine { Vertex { .pos = pos1, .color = color }, Vertex { .pos = pos2, .color = color } });
+	}
+
+	void Renderer::draw_rect(Rect rect, Color color) {
+		_push_command(DrawRect { rect, color, false });
+	}
+
+	void Renderer::draw_rect_fill(Rect rect, Color color) {
+		_push_command(DrawRect { rect, color, true });
+	}
+
+	void Renderer::draw_circle(IVec2 center, int32_t radius, Color color) {
+		_cache_circle_spans(radius);
+		_push_command(DrawCircle { center, radius, color, false });
+	}
+
+	void Renderer::draw_circle_fill(IVec2 center, int32_t radius, Color color) {
+		_cache_circle_spans(radius);
+		_push_command(DrawCircle { center, radius, color, true });
+	}
+
+	void Renderer::draw_triangle(Vertex v1, Vertex v2, Vertex v3) {
+		_push_command(DrawTriangle { v1, v2, v3, false });
+	}
+
+	void Renderer::draw_triangle_fill(Vertex v1, Vertex v2, Vertex v3) {
+		_push_command(DrawTriangle { v1, v2, v3, true });
+	}
+
+	void Renderer::draw_mesh(std::span<const Vertex> vertices, std::span<const uint16_t> indices, std::optional<ImageID> image_id) {
+		DEBUG_ASSERT(indices.size() % 3 == 0, "Mesh indices must come in triples, got %zu", indices.size());
+		if (indices.size() < 3) {
+			return;
+		}
+		for (uint16_t index : indices) {
+			if (index >= vertices.size()) {
+				LOG_WARNING("Mesh index %d out of range of %zu vertices, mesh isn't drawn", index, vertices.size());
+				return;
+			}
+		}
+		_push_command(DrawMesh {
+			.vertices = m_command_arena.push_span(vertices),
+			.indices = m_command_arena.push_span(indices.first(indices.size() - indices.size() % 3)),
+			.image_id = image_id,
+			.bounds = vertex_bounds(vertices),
+		});
+	}
+
+	void Renderer::draw_polyline(std::span<const Vertex> vertices) {
+		if (vertices.size() < 2) {
+			return;
+		}
+		_push_command(DrawPolyline {
+			.vertices = m_command_arena.push_span(vertices),
+			.bounds = vertex_bounds(vertices),
+		});
+	}
+
+	void Renderer::set_sprite_clips(ImageID sheet, std::span<const Rect> clips) {
+		DEBUG_ASSERT(std::ranges::all_of(clips, [](const Rect& clip) { return clip.x >= 0 && clip.y >= 0; }), "Sprite clips must lie inside of sheet %d", sheet.value);
+		m_sprite_clips[sheet.value].assign(clips.begin(), clips.end());
+	}
+
+	void Renderer::draw_sprites(ImageID sheet, std::span<const SpriteInstance> instances) {
+		auto it = m_sprite_clips.find(sheet.value);
+		DEBUG_ASSERT(it != m_sprite_clips.end(), "Drawing sprites of sheet %d without clips, call set_sprite_clips() first", sheet.value);
+		if (instances.empty() || it == m_sprite_clips.end()) {
+			return;
+		}
+		const std::vector<Rect>& clips = it->second;
+		IVec2 top_left = instances[0].pos;
+		IVec2 bottom_right = instances[0].pos;
+		for (const SpriteInstance& instance : instances) {
+			if (instance.clip_index >= clips.size()) {
+				DEBUG_ASSERT(false, "Sprite clip index %d out of range of %zu clips", instance.clip_index, clips.size());
+				return;
+			}
+			const Rect& clip = clips[instance.clip_index];
+			top_left = { engine::min(top_left.x, instance.pos.x), engine::min(top_left.y, instance.pos.y) };
+			bottom_right = { engine::max(bottom_right.x, instance.pos.x + clip.width), engine::max(bottom_right.y, instance.pos.y + clip.height) };
+		}
+		_push_command(DrawSprites {
+			.sheet = sheet,
+			.clips = m_command_arena.push_span(std::span<const Rect>(clips)),
+			.instances = m_command_arena.push_span(instances),
+			.bounds = Rect { top_left.x, top_left.y, bottom_right.x - top_left.x, bottom_right.y - top_left.y },
+			.bins = -1,
+		});
+	}
+
+	void Renderer::draw_image(ImageID image_id, IVec2 pos, DrawImageOptions options) {
+		_draw_image(image_id, Rect { pos.x, pos.y }, options);
+	}
+
+	void Renderer::draw_image_scaled(ImageID image_id, Rect rect, DrawImageOptions options) {
+		_draw_image(image_id, rect, options);
+	}
+
+	void Renderer::_draw_image(ImageID image_id, Rect rect, DrawImageOptions options) {
+		// The caller's palette may be gone by render(), so it's copied along with the command
+		ArenaSpan<Palette> palette_copy = {};
+		if (options.palette) {
+			palette_copy = m_command_arena.push_span(std::span<const Palette>(options.palette, 1));
+			options.palette = nullptr;
+		}
+		_push_command(DrawImage { image_id, rect, options, palette_copy, nullptr });
+	}
+
+	void Renderer::draw_text(FontID font_id, int32_t font_size, Rect rect, Color color, std::string_view text, DrawTextOptions options) {
+		_push_command(DrawText { font_id, font_size, rect, color, m_command_arena.push_string(text), options });
+	}
+
+	void Renderer::draw_tilemap(TileMapID tilemap_id, IVec2 camera_offset, TileMapCaching caching) {
+		_push_command(DrawTileMap { tilemap_id, camera_offset, caching, 0, {} });
+	}
+
+	const Bitmap& Renderer::bitmap() {
+		return m_bitmap;
+	}
+
+	IVec2 Renderer::screen_resolution() const {
+		return m_bitmap.size();
+	}
+
+	const TextLayoutCache& Renderer::text_layout_cache() const {
+		return m_text_layouts;
+	}
+
+	const TransformedImageCache& Renderer::transformed_image_cache() const {
+		return m_transformed_images;
+	}
+
+	const std::vector<Rect>& Renderer::dirty_rects() const {
+		return m_dirty_rects;
+	}
+
+	int64_t Renderer::num_skipped_frames() const {
+		return m_num_skipped_frames;
+	}
+
+	void Renderer::render(const ResourceManager& resources) {
+		CPUProfilingScope_Render();
+		TracyPlot("DrawCommands", (int64_t)m_command_offsets.size());
+		TracyPlot("DrawCommandBytes", (int64_t)m_command_arena.size());
+
+		/* Point draws at copied palettes */
+		// Done once recording is over, since the arena moves while it grows
+		_look_up_palettes(m_command_offsets);
+		for (const RenderTarget& target : m_render_targets) {
+			_look_up_palettes(target.command_offsets);
+		}
+
+		/* Draw into render targets */
+		// Done before the screen, so its commands see the targets' new pixels
+		DEBUG_ASSERT(!m_active_render_target, "begin_render_target() without matching end_render_target()");
+		_render_targets(resources);
+
+		/* Sort commands by draw order */
+		// Stable, so commands with equal keys keep their submission order
+		m_command_sorter.sort(&m_command_keys, &m_command_offsets);
+
+		/* Skip frame if it draws the same as the last one */
+		// Hashed after the render targets, so their new versions are seen
+		bool is_skipped_frame = false;
+		_look_up_tilemap_versions(resources);
+		if (m_frame_skipping || m_dirty_rect_tracking) {
+			const size_t frame_hash = _hash_commands();
+			is_skipped_frame = m_frame_skipping && m_frame_hash == frame_hash;
+			m_frame_hash = frame_hash;
+		}
+		TracyPlot("SkippedFrame", (int64_t)is_skipped_frame);
+
+		if (is_skipped_frame) {
+			m_dirty_rects.clear();
+			m_num_skipped_frames++;
+		}
+		else {
+			/* Look up text layouts */
+			// Done up front since the cache can't be shared between render threads
+			_layout_text(resources);
+
+			/* Drop commands hidden behind later opaque ones */
+			_cull_occluded_commands(resources);
+
+			/* Look up flipped and tinted images */
+			_transform_images(resources);
+
+			/* Pre-render visible tile map chunks */
+			_render_tilemap_chunks(resources);
+
+			/* Run commands */
+			if (m_tiled_rendering || m_dirty_rect_tracking) {
+				_render_tiled(resources);
+			}
+			else {
+				const Rect screen = { 0, 0, m_bitmap.width(), m_bitmap.height() };
+				m_dirty_rects.assign({ screen });
+				for (uint32_t i = 0; i < (uint32_t)m_command_offsets.size(); i++) {
+#ifdef TRACY_ENABLE
+					std::string_view tag = m_command_arena.string(m_command_arena.get<CommandHeader>(m_command_offsets[i]).tag);
+					if (!tag.empty()) {
+						TracyMessage(tag.data(), tag.size());
+					}
+#endif
+					_run_command(&m_bitmap, screen, i, resources);
+				}
+			}
+		}
+
+		/* Reset command buffer, keeping its memory for next frame */
+		m_command_arena.clear();
+		m_command_offsets.clear();
+		m_command_keys.clear();
+		m_frame_text_layouts.clear();
+		m_frame_transformed_images.clear();
+		_evict_tilemap_chunks();
+		m_frame++;
+		m_current_tag = {};
+		m_draw_layer = 0;
+		m_draw_depth.reset();
+		DEBUG_ASSERT(m_clip_rects.empty(), "push_clip_rect() without matching pop_clip_rect()");
+		m_clip_rects.clear();
+	}
+
+	Rect Renderer::_target_rect() const {
+		if (m_active_render_target) {
+			const Bitmap& bitmap = m_render_targets[*m_active_render_target].bitmap;
+			return Rect { 0, 0, bitmap.width(), bitmap.height() };
+		}
+		return Rect { 0, 0, m_bitmap.width(), m_bitmap.height() };
+	}
+
+	const Image& Renderer::_image(ImageID image_id, const ResourceManager& resources) const {
+		if (is_render_target(image_id)) {
+			return m_render_targets[render_target_index(image_id)].image;
+		}
+		return resources.image(image_id);
+	}
+
+	void Renderer::_look_up_palettes(std::span<const uint32_t> command_offsets) {
+		for (uint32_t offset : command_offsets) {
+			if (m_command_arena.get<CommandHeader>(offset).type != CommandType::DrawImage) {
+				continue;
+			}
+			DrawImage& draw_image = m_command_arena.get<CommandRecord<DrawImage>>(offset).command;
+			if (draw_image.palette_copy.length > 0) {
+				draw_image.options.palette = m_command_arena.span(draw_image.palette_copy).data();
+			}
+		}
+	}
+
+	void Renderer::_render_targets(const ResourceManager& resources) {
+		CPUProfilingScope_Render();
+		for (RenderTarget& target : m_render_targets) {
+			if (target.command_offsets.empty()) {
+				continue;
+			}
+
+			/* Run target's commands in place of the screen's */
+			// Targets are drawn rarely, so they're drawn serially without tiling
+			std::swap(m_command_offsets, target.command_offsets);
+			std::swap(m_command_keys, target.command_keys);
+			m_command_sorter.sort(&m_command_keys, &m_command_offsets);
+			bool is_skipped_frame = false;
+			_look_up_tilemap_versions(resources);
+			if (m_frame_skipping) {
+				const size_t commands_hash = _hash_commands();
+				is_skipped_frame = target.commands_hash == commands_hash;
+				target.commands_hash = commands_hash;
+			}
+			if (!is_skipped_frame) {
+				_layout_text(resources);
+				_transform_images(resources);
+				_render_tilemap_chunks(resources);
+				const Rect target_rect = { 0, 0, target.bitmap.width(), target.bitmap.height() };
+				for (uint32_t i = 0; i < (uint32_t)m_command_offsets.size(); i++) {
+					_run_command(&target.bitmap, target_rect, i, resources);
+				}
+			}
+			std::swap(m_command_offsets, target.command_offsets);
+			std::swap(m_command_keys, target.command_keys);
+			target.command_offsets.clear();
+			target.command_keys.clear();
+
+			/* Update image drawn by the screen's commands */
+			// Skipped targets keep their pixels, so the screen doesn't need to redraw them
+			if (!is_skipped_frame) {
+				target.image = target.bitmap.to_image();
+				target.version++;
+			}
+		}
+	}
+
+	template <typename T>
+	Rect Renderer::_recorded_bounds(const T& command) const {
+		// NOTE: resources aren't known while recording, so sizes that depend on
+		// them (whole images, text without a width) extend to the screen edge.
+		const Rect screen = _target_rect();
+		auto to_screen_edge = [&](int32_t start, int32_t screen_size) { return engine::max(screen_size - start, 1); };
+		if constexpr (std::is_same_v<T, ClearScreen>) {
+			return screen;
+		}
+		else if constexpr (std::is_same_v<T, DrawPoint>) {
+			return Rect { command.v1.pos.x, command.v1.pos.y, 1, 1 };
+		}
+		else if constexpr (std::is_same_v<T, DrawLine>) {
+			return bounding_rect({ command.v1.pos, command.v2.pos });
+		}
+		else if constexpr (std::is_same_v<T, DrawRect>) {
+			return bounding_rect({ command.rect.pos(), command.rect.pos() + IVec2 { command.rect.width - 1, command.rect.height - 1 } });
+		}
+		else if constexpr (std::is_same_v<T, DrawCircle>) {
+			return bounding_rect({ command.center - IVec2 { command.radius, command.radius }, command.center + IVec2 { command.radius, command.radius } });
+		}
+		else if constexpr (std::is_same_v<T, DrawTriangle>) {
+			return bounding_rect({ command.v1.pos, command.v2.pos, command.v3.pos });
+		}
+		else if constexpr (std::is_same_v<T, DrawImage>) {
+			const Rect& rect = command.rect;
+			if (!rect.empty()) {
+				return bounding_rect({ rect.pos(), rect.pos() + IVec2 { rect.width - 1, rect.height - 1 } });
+			}
+			if (!command.options.clip.empty()) {
+				return Rect { rect.x, rect.y, command.options.clip.width, command.options.clip.height };
+			}
+			return Rect { rect.x, rect.y, to_screen_edge(rect.x, screen.width), to_screen_edge(rect.y, screen.height) };
+		}
+		else if constexpr (std::is_same_v<T, DrawText>) {
+			// Glyphs can extend past the text box (e.g. descenders), so pad it by a line
+			const Rect& rect = command.rect;
+			const int32_t font_size = command.font_size;
+			const int32_t width = rect.width != 0 ? rect.width : to_screen_edge(rect.x, screen.width);
+			const int32_t height = rect.height != 0 ? rect.height : font_size + 1;
+			return Rect { rect.x - font_size, rect.y - font_size, width + 2 * font_size, height + 2 * font_size };
+		}
+		else if constexpr (std::is_same_v<T, DrawTileMap>) {
+			const IVec2 pos = { -command.camera_offset.x, -command.camera_offset.y };
+			return Rect { pos.x, pos.y, to_screen_edge(pos.x, screen.width), to_screen_edge(pos.y, screen.height) };
+		}
+		else if constexpr (std::is_same_v<T, DrawMesh> || std::is_same_v<T, DrawPolyline> || std::is_same_v<T, DrawSprites>) {
+			return command.bounds;
+		}
+	}
+
+	template <typename T>
+	void Renderer::_push_command(const T& command) {
+		/* Cull commands outside of the clip rect */
+		const ArenaString tag = std::exchange(m_current_tag, ArenaString {});
+		const Rect clip = m_clip_rects.empty() ? _target_rect() : m_clip_rects.back();
+		if (!Rect::intersection(_recorded_bounds(command), clip).has_area()) {
+			return;
+		}
+
+		CommandRecord<T> record = {
+			.header = { .type = T::TYPE, .tag = tag, .clip = clip },
+			.command = command,
+		};
+		RenderTarget* target = m_active_render_target ? &m_render_targets[*m_active_render_target] : nullptr;
+		(target ? target->command_offsets : m_command_offsets).push_back(m_command_arena.push(record));
+
+		// Images are only batched when given a depth, since then the order
+		// between draws of equal depth is left up to the renderer.
+		uint32_t batch = 0;
+		if constexpr (std::is_same_v<T, DrawImage>) {
+			if (m_draw_depth) {
+				batch = image_batch(command.image_id);
+			}
+		}
+		else if constexpr (std::is_same_v<T, DrawSprites>) {
+			if (m_draw_depth) {
+				batch = image_batch(command.sheet);
+			}
+		}
+		(target ? target->command_keys : m_command_keys).push_back(draw_order_key(m_draw_layer, m_draw_depth.value_or(0), batch));
+	}
+
+	template <typename T>
+	const T& Renderer::_command(uint32_t index) const {
+		return m_command_arena.get<CommandRecord<T>>(m_command_offsets[index]).command;
+	}
+
+	void Renderer::_layout_text(const ResourceManager& resources) {
+		CPUProfilingScope_Render();
+		for (uint32_t offset : m_command_offsets) {
+			if (m_command_arena.get<CommandHeader>(offset).type != CommandType::DrawText) {
+				continue;
+			}
+			DrawText& draw_text = m_command_arena.get<CommandRecord<DrawText>>(offset).command;
+			std::shared_ptr<const TextLayout> layout = m_text_layouts.layout(
+				resources.typeface(draw_text.font_id),
+				draw_text.font_id,
+				draw_text.font_size,
+				IVec2 { draw_text.rect.width, draw_text.rect.height },
+				draw_text.options.h_alignment,
+				m_command_arena.string(draw_text.text));
+			draw_text.layout = layout.get();
+			m_frame_text_layouts.push_back(std::move(layout));
+		}
+		TextLayoutCache::Stats stats = m_text_layouts.stats();
+		TracyPlot("TextLayoutCacheHits", stats.hits);
+		TracyPlot("TextLayoutCacheMisses", stats.misses);
+	}
+
+	void Renderer::_transform_images(const ResourceManager& resources) {
+		CPUProfilingScope_Render();
+		if (m_transformed_images.budget() == 0) {
+			return;
+		}
+		for (uint32_t offset : m_command_offsets) {
+			if (m_command_arena.get<CommandHeader>(offset).type != CommandType::DrawImage) {
+				continue;
+			}
+			// Scaled draws sample the image anyway, so only unscaled draws gain from a copy
+			// Render targets and palettes change without changing id, so they can't be cached by id
+			DrawImage& draw_image = m_command_arena.get<CommandRecord<DrawImage>>(offset).command;
+			const DrawImageOptions& options = draw_image.options;
+			const bool is_tinted = options.tint.a > 0 && options.tint != Color::white();
+			if (!draw_image.rect.empty() || (!is_tinted && !options.flip_h && !options.flip_v) || is_render_target(draw_image.image_id) || options.palette) {
+				continue;
+			}
+			const Image& image = _image(draw_image.image_id, resources);
+			const Rect clip = options.clip.empty() ? Rect { 0, 0, image.width, image.height } : options.clip;
+			const bool is_inside_image = clip.x >= 0 && clip.y >= 0 && clip.x + clip.width <= image.width && clip.y + clip.height <= image.height;
+			if (!clip.has_area() || !is_inside_image) {
+				continue;
+			}
+			std::shared_ptr<const Image> transformed = m_transformed_images.image(image, draw_image.image_id, clip, options.flip_h, options.flip_v, options.tint);
+			draw_image.transformed = transformed.get();
+			m_frame_transformed_images.push_back(std::move(transformed));
+		}
+		TransformedImageCache::Stats stats = m_transformed_images.stats();
+		TracyPlot("TransformedImageCacheHits", stats.hits);
+		TracyPlot("TransformedImageCacheMisses", stats.misses);
+		TracyPlot("TransformedImageCacheEvictions", stats.evictions);
+		TracyPlot("TransformedImageCacheBytes", (int64_t)stats.bytes);
+	}
+
+	// Done before hashing, since tile edits don't change the recorded commands
+	void Renderer::_look_up_tilemap_versions(const ResourceManager& resources) {
+		for (uint32_t offset : m_command_offsets) {
+			if (m_command_arena.get<CommandHeader>(offset).type != CommandType::DrawTileMap) {
+				continue;
+			}
+			DrawTileMap& draw_tilemap = m_command_arena.get<CommandRecord<DrawTileMap>>(offset).command;
+			const TileMap& tilemap = resources.tilemap(draw_tilemap.tilemap_id);
+			const ImageID tileset = tilemap.tileset();
+			draw_tilemap.version = tilemap.version();
+			draw_tilemap.cache_key = TileMapCacheKey {
+				.tilemap_identity = tilemap.identity(),
+				.tileset = tileset,
+				.tileset_version = is_render_target(tileset) ? m_render_targets[render_target_index(tileset)].version : 0,
+				.tile_size = tilemap.tile_size(),
+				.size = tilemap.size(),
+			};
+		}
+	}
+
+	void Renderer::_render_tilemap_chunks(const ResourceManager& resources) {
+		CPUProfilingScope_Render();
+		int64_t num_rendered_chunks = 0;
+		int64_t num_scrolled_tiles = 0;
+		for (uint32_t offset : m_command_offsets) {
+			const CommandHeader& header = m_command_arena.get<CommandHeader>(offset);
+			if (header.type != CommandType::DrawTileMap) {
+				continue;
+			}
+			const DrawTileMap& draw_tilemap = m_command_arena.get<CommandRecord<DrawTileMap>>(offset).command;
+			const TileMap& tilemap = resources.tilemap(draw_tilemap.tilemap_id);
+
+			/* Scroll buffer covers the whole clip rect */
+			if (draw_tilemap.caching == TileMapCaching::ScrollBuffer) {
+				TileMapScrollBuffer& scroll_buffer = m_tilemap_scroll_buffers[draw_tilemap.tilemap_id.value];
+				if (scroll_buffer.key != draw_tilemap.cache_key) {
+					scroll_buffer.key = draw_tilemap.cache_key;
+					scroll_buffer.buffer = ScrollBuffer {};
+				}
+				const IVec2 pos = { -draw_tilemap.camera_offset.x, -draw_tilemap.camera_offset.y };
+				scroll_buffer.buffer.update(tilemap, _image(tilemap.tileset(), resources), pos, header.clip);
+				scroll_buffer.last_drawn_frame = m_frame;
+				num_scrolled_tiles += scroll_buffer.buffer.num_copied_tiles();
+				continue;
+			}
+
+			const IVec2 num_chunks = tilemap.num_chunks();
+			const IVec2 tile_size = tilemap.tile_size();
+			const IVec2 chunk_pixel_size = TileMap::CHUNK_SIZE * tile_size;
+			TileMapChunks& cached_chunks = m_tilemap_chunks[draw_tilemap.tilemap_id.value];
+			if (cached_chunks.key != draw_tilemap.cache_key) {
+				cached_chunks.key = draw_tilemap.cache_key;
+				cached_chunks.chunks.assign((size_t)num_chunks.x * num_chunks.y, TileMapChunk {});
+			}
+			std::vector<TileMapChunk>& chunks = cached_chunks.chunks;
+
+			/* Only visit chunks inside of the clip rect */
+			const IVec2 pos = { -draw_tilemap.camera_offset.x, -draw_tilemap.camera_offset.y };
+			const Rect visible = Rect::intersection(Rect { pos.x, pos.y, tilemap.pixel_size().x, tilemap.pixel_size().y }, header.clip);
+			if (!visible.has_area() || chunk_pixel_size.x <= 0 || chunk_pixel_size.y <= 0) {
+				continue;
+			}
+			const IVec2 first_chunk = { (visible.x - pos.x) / chunk_pixel_size.x, (visible.y - pos.y) / chunk_pixel_size.y };
+			const IVec2 last_chunk = { (visible.x + visible.width - 1 - pos.x) / chunk_pixel_size.x, (visible.y + visible.height - 1 - pos.y) / chunk_pixel_size.y };
+			const Image& tileset = _image(tilemap.tileset(), resources);
+			const int32_t tileset_columns = engine::max(tileset.width / engine::max(tile_size.x, 1), 1);
+			for (int32_t chunk_y = first_chunk.y; chunk_y <= last_chunk.y; chunk_y++) {
+				for (int32_t chunk_x = first_chunk.x; chunk_x <= last_chunk.x; chunk_x++) {
+					TileMapChunk& chunk = chunks[chunk_x + (size_t)chunk_y * num_chunks.x];
+					chunk.last_drawn_frame = m_frame;
+					const uint32_t version = tilemap.chunk_version(chunk_x, chunk_y);
+					if (!chunk.image.pixels.empty() && chunk.version == version) {
+						continue;
+					}
+
+					/* Copy tile rows from tileset, leaving empty tiles transparent */
+					const IVec2 first_tile = { chunk_x * TileMap::CHUNK_SIZE, chunk_y * TileMap::CHUNK_SIZE };
+					const IVec2 num_tiles = {
+						engine::min(TileMap::CHUNK_SIZE, tilemap.size().x - first_tile.x),
+						engine::min(TileMap::CHUNK_SIZE, tilemap.size().y - first_tile.y),
+					};
+					const int32_t width = num_tiles.x * tile_size.x;
+					const int32_t height = num_tiles.y * tile_size.y;
+					std::vector<Pixel> pixels((size_t)width * height, Pixel {});
+					for (int32_t tile_y = 0; tile_y < num_tiles.y; tile_y++) {
+						for (int32_t tile_x = 0; tile_x < num_tiles.x; tile_x++) {
+							const uint16_t tile = tilemap.tile(first_tile.x + tile_x, first_tile.y + tile_y);
+							const IVec2 src = { (tile % tileset_columns) * tile_size.x, (tile / tileset_columns) * tile_size.y };
+							if (tile == TileMap::EMPTY_TILE || src.x + tile_size.x > tileset.width || src.y + tile_size.y > tileset.height) {
+								continue;
+							}
+							for (int32_t y = 0; y < tile_size.y; y++) {
+								const Pixel* src_row = &tileset.pixels[src.x + (size_t)(src.y + y) * tileset.width];
+								Pixel* dst_row = &pixels[tile_x * tile_size.x + (size_t)(tile_y * tile_size.y + y) * width];
+								std::copy(src_row, src_row + tile_size.x, dst_row);
+							}
+						}
+					}
+					chunk.image = Image::from_pixels(width, height, std::move(pixels));
+					chunk.version = version;
+					num_rendered_chunks++;
+				}
+			}
+		}
+		TracyPlot("TileMapChunksRendered", num_rendered_chunks);
+		TracyPlot("TileMapTilesScrolledIn", num_scrolled_tiles);
+	}
+
+	void Renderer::_evict_tilemap_chunks() {
+		for (auto& [tilemap_id, cached_chunks] : m_tilemap_chunks) {
+			for (TileMapChunk& chunk : cached_chunks.chunks) {
+				if (!chunk.image.pixels.empty() && m_frame - chunk.last_drawn_frame > MAX_UNDRAWN_TILEMAP_CHUNK_FRAMES) {
+					chunk.image = Image {};
+				}
+			}
+		}
+		std::erase_if(m_tilemap_scroll_buffers, [&](const auto& id_buffer) {
+			return m_frame - id_buffer.second.last_drawn_frame > MAX_UNDRAWN_TILEMAP_CHUNK_FRAMES;
+		});
+	}
+
+	Renderer::CircleSpans Renderer::_compute_circle_spans(int32_t radius) {
+		CircleSpans spans;
+		if (radius < 0) {
+			return spans;
+		}
+
 		/* Compute points in 2nd octant */
 		// We utilize that y value increases monotonously in the first octant,
 		// and check which pixel is closest to the radius at a given x-value.
@@ -32,251 +1275,736 @@ namespace engine {
 		//   ,                       ,
 		//     ,                  , '
 		//       ' - , _ _ _ ,  '
-		std::vector<IVec2> octant_points;
+		std::vector<IVec2> octant;
 		IVec2 point = { 0, radius };
 		while (point.x <= point.y) {
-			octant_points.push_back(point);
-			int32_t midpoint_x = point.x + 1;
-			float midpoint_y = point.y - 0.5f;
-			if (pow(midpoint_x, 2) + pow(midpoint_y, 2) > pow(radius, 2)) {
+			octant.push_back(point);
+			// midpoint (x + 1, y - 0.5) scaled by 2 to stay in integers,
+			// and squared in 64 bits since large radii overflow 32 bits
+			int64_t midpoint_x = 2 * (int64_t)(point.x + 1);
+			int64_t midpoint_y = 2 * (int64_t)point.y - 1;
+			if (midpoint_x * midpoint_x + midpoint_y * midpoint_y > 4 * (int64_t)radius * radius) {
 				point.y -= 1;
 			}
 			point.x += 1;
 		}
-		return octant_points;
-	}
 
-	static std::vector<IVec2> quarter_circle_points(int32_t radius) {
-		/* Compute quarter circle*/
+		/* Compute quarter circle */
 		//         , - ~ ~ ~ - ,
 		//     , '       |       ' ,
 		//   ,           |           ,
 		//  ,            |            ,
 		// ,             |             ,
 		// '-------------o-------------'
-		std::vector<IVec2> octant = circle_octant_points(radius);
-		std::vector<IVec2> quarter_circle;
-		int prev_y = INT32_MIN;
-
-		// Add octant points
-		for (IVec2 point : octant) {
-			if (point.y != prev_y) {
-				quarter_circle.push_back(point);
-				prev_y = point.y;
+		// Every row gets the first point of the octant, or its mirror, landing on it.
+		spans.half_widths.resize(radius + 1);
+		int32_t prev_y = INT32_MIN;
+		for (IVec2 octant_point : octant) {
+			if (octant_point.y != prev_y) {
+				spans.half_widths[octant_point.y] = octant_point.x;
+				prev_y = octant_point.y;
 			}
 		}
-
-		// Mirror octant
 		// iterate reverse order to get monotonically
 		// decreasing y value in the flipped point
-		for (int i = (int)octant.size() - 1; i >= 0; i--) {
-			IVec2 point = { octant[i].y, octant[i].x }; // flipped (x,y)
-			if (point.y != prev_y) {
-				quarter_circle.push_back(point);
-				prev_y = point.y;
+		for (auto it = octant.rbegin(); it != octant.rend(); ++it) {
+			if (it->x != prev_y) {
+				spans.half_widths[it->x] = it->y;
+				prev_y = it->x;
 			}
 		}
 
-		return quarter_circle;
-	}
-
-	Renderer Renderer::with_bitmap(int32_t width, int32_t height) {
-		Renderer renderer;
-		renderer.m_bitmap = Bitmap::with_size(width, height);
-		return renderer;
-	}
-
-	void Renderer::add_tag(std::string tag) {
-		m_current_tag = tag;
-	}
-
-	void Renderer::clear_screen(Color color) {
-		m_draw_data.push_back(DrawData { ClearScreen { color }, _take_current_tag() });
-	}
-
-	void Renderer::draw_point(Vertex v1) {
-		m_draw_data.push_back(DrawData { DrawPoint { v1 }, _take_current_tag() });
-	}
-
-	void Renderer::draw_line(Vertex v1, Vertex v2) {
-		m_draw_data.push_back(DrawData { DrawLine { v1, v2 }, _take_current_tag() });
-	}
-
-	void Renderer::draw_line(IVec2 pos1, IVec2 pos2, Color color) {
-		m_draw_data.push_back(DrawData { DrawLine { Vertex { .pos = pos1, .color = color }, Vertex { .pos = pos2, .color = color } }, _take_current_tag() });
-	}
+		/* Compute outline rows */
+		// The octant and its mirror cover a contiguous run of each row in the quarter circle
+		spans.outline_rows.resize(radius + 1, IVec2 { INT32_MAX, INT32_MIN });
+		auto add_to_row = [&](int32_t row, int32_t x) {
+			spans.outline_rows[row].x = engine::min(spans.outline_rows[row].x, x);
+			spans.outline_rows[row].y = engine::max(spans.outline_rows[row].y, x);
+		};
+		for (IVec2 octant_point : octant) {
+			add_to_row(octant_point.y, octant_point.x);
+			add_to_row(octant_point.x, octant_point.y);
+		}
 
-	void Renderer::draw_rect(Rect rect, Color color) {
-		m_draw_data.push_back(DrawData { DrawRect { rect, color, false }, _take_current_tag() });
+		return spans;
 	}
 
-	void Renderer::draw_rect_fill(Rect rect, Color color) {
-		m_draw_data.push_back(DrawData { DrawRect { rect, color, true }, _take_current_tag() });
+	void Renderer::_cache_circle_spans(int32_t radius) {
+		if (radius < 0 || radius > MAX_CACHED_CIRCLE_RADIUS) {
+			return;
+		}
+		if ((int32_t)m_circle_spans.size() <= radius) {
+			m_circle_spans.resize(radius + 1);
+		}
+		if (m_circle_spans[radius].half_widths.empty()) {
+			m_circle_spans[radius] = _compute_circle_spans(radius);
+		}
 	}
 
-	void Renderer::draw_circle(IVec2 center, int32_t radius, Color color) {
-		m_draw_data.push_back(DrawData { DrawCircle { center, radius, color, false }, _take_current_tag() });
+	Rect Renderer::_command_bounds(uint32_t index, const ResourceManager& resources) const {
+		// NOTE: bounds must cover every pixel a command can write, since tiled
+		// rendering will skip the command for any tile outside of its bounds.
+		const CommandHeader& header = m_command_arena.get<CommandHeader>(m_command_offsets[index]);
+		Rect bounds = {};
+		switch (header.type) {
+			case CommandType::ClearScreen: bounds = _recorded_bounds(_command<ClearScreen>(index)); break;
+			case CommandType::DrawPoint: bounds = _recorded_bounds(_command<DrawPoint>(index)); break;
+			case CommandType::DrawLine: bounds = _recorded_bounds(_command<DrawLine>(index)); break;
+			case CommandType::DrawRect: bounds = _recorded_bounds(_command<DrawRect>(index)); break;
+			case CommandType::DrawCircle: bounds = _recorded_bounds(_command<DrawCircle>(index)); break;
+			case CommandType::DrawTriangle: bounds = _recorded_bounds(_command<DrawTriangle>(index)); break;
+			case CommandType::DrawImage: {
+				const auto& [image_id, rect, options, palette_copy, transformed] = _command<DrawImage>(index);
+				if (rect.empty() && options.clip.empty()) {
+					const Image& image = _image(image_id, resources);
+					bounds = Rect { rect.x, rect.y, image.width, image.height };
+				}
+				else {
+					bounds = _recorded_bounds(_command<DrawImage>(index));
+				}
+				break;
+			}
+			case CommandType::DrawText: {
+				const auto& [font_id, font_size, rect, color, text, options, layout] = _command<DrawText>(index);
+				// Glyphs can extend past the text box (e.g. descenders), so pad it by a line
+				IVec2 size = layout->size;
+				bounds = Rect { rect.x - font_size, rect.y - font_size, size.x + 2 * font_size, size.y + 2 * font_size };
+				break;
+			}
+			case CommandType::DrawTileMap: {
+				const auto& [tilemap_id, camera_offset, caching, version, cache_key] = _command<DrawTileMap>(index);
+				const IVec2 size = resources.tilemap(tilemap_id).pixel_size();
+				bounds = Rect { -camera_offset.x, -camera_offset.y, size.x, size.y };
+				break;
+			}
+			case CommandType::DrawMesh: bounds = _recorded_bounds(_command<DrawMesh>(index)); break;
+			case CommandType::DrawPolyline: bounds = _recorded_bounds(_command<DrawPolyline>(index)); break;
+			case CommandType::DrawSprites: bounds = _recorded_bounds(_command<DrawSprites>(index)); break;
+		}
+		return Rect::intersection(bounds, header.clip);
 	}
 
-	void Renderer::draw_circle_fill(IVec2 center, int32_t radius, Color color) {
-		m_draw_data.push_back(DrawData { DrawCircle { center, radius, color, true }, _take_current_tag() });
+	Rect Renderer::_opaque_bounds(uint32_t index, const ResourceManager& resources) const {
+		// NOTE: unlike _command_bounds(), every pixel inside of these bounds must
+		// be overwritten with an opaque pixel, since commands below it are dropped.
+		const CommandHeader& header = m_command_arena.get<CommandHeader>(m_command_offsets[index]);
+		Rect bounds = {};
+		switch (header.type) {
+			case CommandType::ClearScreen: {
+				// Clears replace pixels, even with a translucent color
+				bounds = _recorded_bounds(_command<ClearScreen>(index));
+				break;
+			}
+			case CommandType::DrawRect: {
+				const auto& [rect, color, filled] = _command<DrawRect>(index);
+				if (filled && color.a == 255) {
+					bounds = rect;
+				}
+				break;
+			}
+			case CommandType::DrawImage: {
+				const auto& [image_id, rect, options, palette_copy, transformed] = _command<DrawImage>(index);
+				const Image& image = _image(image_id, resources);
+				const AlphaMode alpha_mode = options.palette && image.is_indexed() ? options.palette->alpha_mode(image.num_indexed_colors) : image.alpha_mode;
+				if (alpha_mode != AlphaMode::Opaque || options.alpha != 1.0f) {
+					break;
+				}
+				const Rect image_rect = { 0, 0, image.width, image.height };
+				if (!rect.empty()) {
+					// Scaled images fill their rect unless they sample nothing at all
+					const Rect src_rect = options.clip.empty() ? image_rect : Rect::intersection(options.clip, image_rect);
+					bounds = src_rect.has_area() ? rect : Rect {};
+				}
+				else {
+					// Same destination as _put_image()
+					const Rect clip = options.clip.empty() ? image_rect : options.clip;
+					const int32_t width = engine::min(clip.width, image.width);
+					const int32_t height = engine::min(clip.height, image.height);
+					bounds = Rect {
+						options.flip_h ? rect.x + (clip.width - width) : rect.x,
+						options.flip_v ? rect.y + (clip.height - height) : rect.y,
+						width,
+						height,
+					};
+				}
+				break;
+			}
+			default: break;
+		}
+		return Rect::intersection(bounds, header.clip);
 	}
 
-	void Renderer::draw_triangle(Vertex v1, Vertex v2, Vertex v3) {
-		m_draw_data.push_back(DrawData { DrawTriangle { v1, v2, v3, false }, _take_current_tag() });
-	}
+	void Renderer::_cull_occluded_commands(const ResourceManager& resources) {
+		CPUProfilingScope_Render();
+		// Walks the commands from last to first, collecting the largest opaque
+		// rects drawn so far. A command inside of one of them is never seen, and
+		// a command sticking out on one side only needs to draw the part outside.
+		Rect occluders[MAX_OCCLUDERS];
+		int32_t num_occluders = 0;
+		auto area = [](Rect rect) { return (int64_t)rect.width * rect.height; };
+		const bool has_hashes = m_frame_skipping || m_dirty_rect_tracking;
+		const uint32_t num_commands = (uint32_t)m_command_offsets.size();
+		uint32_t first_kept = num_commands;
+		for (uint32_t i = num_commands; i-- > 0;) {
+			/* Find part not covered by later commands */
+			Rect visible = _command_bounds(i, resources);
+			for (int32_t j = 0; j < num_occluders && visible.has_area(); j++) {
+				visible = uncovered_rect(visible, occluders[j]);
+			}
+			if (!visible.has_area()) {
+				continue;
+			}
 
-	void Renderer::draw_triangle_fill(Vertex v1, Vertex v2, Vertex v3) {
-		m_draw_data.push_back(DrawData { DrawTriangle { v1, v2, v3, true }, _take_current_tag() });
-	}
+			/* Remember command if it's opaque */
+			// Replaces the smallest occluder once there are enough of them
+			const Rect opaque = _opaque_bounds(i, resources);
+			if (opaque.has_area()) {
+				if (num_occluders < MAX_OCCLUDERS) {
+					occluders[num_occluders++] = opaque;
+				}
+				else {
+					Rect* smallest = std::min_element(occluders, occluders + MAX_OCCLUDERS, [&](Rect lhs, Rect rhs) { return area(lhs) < area(rhs); });
+					if (area(*smallest) < area(opaque)) {
+						*smallest = opaque;
+					}
+				}
+			}
 
-	void Renderer::draw_image(ImageID image_id, IVec2 pos, DrawImageOptions options) {
-		m_draw_data.push_back(DrawData { DrawImage { image_id, Rect { pos.x, pos.y }, options }, _take_current_tag() });
-	}
+			/* Clip command to visible part */
+			// ScrollBuffer tile maps keep their clip, since their buffer is sized by it
+			CommandHeader& header = m_command_arena.get<CommandHeader>(m_command_offsets[i]);
+			const bool is_scroll_buffer = header.type == CommandType::DrawTileMap && _command<DrawTileMap>(i).caching == TileMapCaching::ScrollBuffer;
+			if (!is_scroll_buffer) {
+				header.clip = Rect::intersection(header.clip, visible);
+			}
 
-	void Renderer::draw_image_scaled(ImageID image_id, Rect rect, DrawImageOptions options) {
-		m_draw_data.push_back(DrawData { DrawImage { image_id, rect, options }, _take_current_tag() });
+			/* Keep command, packing kept commands at the back */
+			first_kept--;
+			m_command_offsets[first_kept] = m_command_offsets[i];
+			m_command_keys[first_kept] = m_command_keys[i];
+			if (has_hashes) {
+				m_command_hashes[first_kept] = m_command_hashes[i];
+			}
+		}
+
+		/* Move kept commands to the front */
+		TracyPlot("CulledCommands", (int64_t)first_kept);
+		m_command_offsets.erase(m_command_offsets.begin(), m_command_offsets.begin() + first_kept);
+		m_command_keys.erase(m_command_keys.begin(), m_command_keys.begin() + first_kept);
+		if (has_hashes) {
+			m_command_hashes.erase(m_command_hashes.begin(), m_command_hashes.begin() + first_kept);
+		}
 	}
 
-	void Renderer::draw_text(FontID font_id, int32_t font_size, Rect rect, Color color, std::string text, DrawTextOptions options) {
-		m_draw_data.push_back(DrawData { DrawText { font_id, font_size, rect, color, text, options }, _take_current_tag() });
+	size_t Renderer::_command_hash(uint32_t index) const {
+		// NOTE: fields are hashed one by one, since struct padding and arena
+		// offsets differ between frames even when the command doesn't.
+		CommandHasher hasher;
+		const CommandHeader& header = m_command_arena.get<CommandHeader>(m_command_offsets[index]);
+		const CommandType type = header.type;
+		hasher.add(type);
+		hasher.add(header.clip);
+		switch (type) {
+			case CommandType::ClearScreen: {
+				const auto& [color] = _command<ClearScreen>(index);
+				hasher.add(color);
+				break;
+			}
+			case CommandType::DrawPoint: {
+				const auto& [v1] = _command<DrawPoint>(index);
+				hasher.add(v1);
+				break;
+			}
+			case CommandType::DrawLine: {
+				const auto& [v1, v2] = _command<DrawLine>(index);
+				hasher.add(v1);
+				hasher.add(v2);
+				break;
+			}
+			case CommandType::DrawRect: {
+				const auto& [rect, color, filled] = _command<DrawRect>(index);
+				hasher.add(rect);
+				hasher.add(color);
+				hasher.add(filled);
+				break;
+			}
+			case CommandType::DrawCircle: {
+				const auto& [center, radius, color, filled] = _command<DrawCircle>(index);
+				hasher.add(center);
+				hasher.add(radius);
+				hasher.add(color);
+				hasher.add(filled);
+				break;
+			}
+			case CommandType::DrawTriangle: {
+				const auto& [v1, v2, v3, filled] = _command<DrawTriangle>(index);
+				hasher.add(v1);
+				hasher.add(v2);
+				hasher.add(v3);
+				hasher.add(filled);
+				break;
+			}
+			case CommandType::DrawImage: {
+				const auto& [image_id, rect, options, palette_copy, transformed] = _command<DrawImage>(index);
+				hasher.add(image_id.value);
+				hasher.add(rect);
+				hasher.add(options);
+				if (is_render_target(image_id)) {
+					hasher.add(m_render_targets[render_target_index(image_id)].version);
+				}
+				break;
+			}
+			case CommandType::DrawText: {
+				const auto& [font_id, font_size, rect, color, text, options, layout] = _command<DrawText>(index);
+				hasher.add(font_id.value);
+				hasher.add(font_size);
+				hasher.add(rect);
+				hasher.add(color);
+				hasher.add(m_command_arena.string(text));
+				hasher.add(options);
+				break;
+			}
+			case CommandType::DrawTileMap: {
+				const auto& [tilemap_id, camera_offset, caching, version, cache_key] = _command<DrawTileMap>(index);
+				hasher.add(tilemap_id.value);
+				hasher.add(camera_offset);
+				hasher.add(caching);
+				hasher.add(version);
+				hasher.add(cache_key.tilemap_identity);
+				hasher.add(cache_key.tileset.value);
+				hasher.add(cache_key.tileset_version);
+				hasher.add(cache_key.tile_size);
+				hasher.add(cache_key.size);
+				break;
+			}
+			case CommandType::DrawMesh: {
+				const auto& [vertices, indices, image_id, bounds] = _command<DrawMesh>(index);
+				for (const Vertex& vertex : m_command_arena.span(vertices)) {
+					hasher.add(vertex);
+				}
+				for (uint16_t vertex_index : m_command_arena.span(indices)) {
+					hasher.add(vertex_index);
+				}
+				hasher.add(image_id.has_value());
+				if (image_id) {
+					hasher.add(image_id->value);
+					if (is_render_target(*image_id)) {
+						hasher.add(m_render_targets[render_target_index(*image_id)].version);
+					}
+				}
+				break;
+			}
+			case CommandType::DrawPolyline: {
+				const auto& [vertices, bounds] = _command<DrawPolyline>(index);
+				for (const Vertex& vertex : m_command_arena.span(vertices)) {
+					hasher.add(vertex);
+				}
+				break;
+			}
+			case CommandType::DrawSprites: {
+				const auto& [sheet, clips, instances, bounds, bins] = _command<DrawSprites>(index);
+				hasher.add(sheet.value);
+				if (is_render_target(sheet)) {
+					hasher.add(m_render_targets[render_target_index(sheet)].version);
+				}
+				for (const Rect& clip : m_command_arena.span(clips)) {
+					hasher.add(clip);
+				}
+				for (const SpriteInstance& instance : m_command_arena.span(instances)) {
+					hasher.add(instance);
+				}
+				break;
+			}
+		}
+		return hasher.hash;
 	}
 
-	const Bitmap& Renderer::bitmap() {
-		return m_bitmap;
+	// Hashes every command into m_command_hashes, and returns the hash of them all
+	size_t Renderer::_hash_commands() {
+		CPUProfilingScope_Render();
+		CommandHasher hasher;
+		hasher.add(m_command_offsets.size());
+		m_command_hashes.resize(m_command_offsets.size());
+		for (uint32_t i = 0; i < (uint32_t)m_command_offsets.size(); i++) {
+			m_command_hashes[i] = _command_hash(i);
+			hasher.add(m_command_hashes[i]);
+		}
+		return hasher.hash;
 	}
 
-	IVec2 Renderer::screen_resolution() const {
-		return m_bitmap.size();
+	// `tile` is the tile being rasterized when rendering tiles, -1 otherwise
+	void Renderer::_run_command(Bitmap* bitmap, Rect bitmap_clip, uint32_t index, const ResourceManager& resources, int32_t tile) {
+		const CommandHeader& header = m_command_arena.get<CommandHeader>(m_command_offsets[index]);
+		const Rect clip = Rect::intersection(bitmap_clip, header.clip);
+		if (!clip.has_area()) {
+			return;
+		}
+		switch (header.type) {
+			case CommandType::ClearScreen: {
+				const auto& [color] = _command<ClearScreen>(index);
+				_clear_screen(bitmap, clip, color);
+				break;
+			}
+			case CommandType::DrawPoint: {
+				const auto& [v1] = _command<DrawPoint>(index);
+				_put_point(bitmap, clip, v1);
+				break;
+			}
+			case CommandType::DrawLine: {
+				const auto& [v1, v2] = _command<DrawLine>(index);
+				_put_line(bitmap, clip, v1, v2, nullptr);
+				break;
+			}
+			case CommandType::DrawRect: {
+				const auto& [rect, color, filled] = _command<DrawRect>(index);
+				if (filled) {
+					_put_rect_fill(bitmap, clip, rect, color);
+				}
+				else {
+					_put_rect(bitmap, clip, rect, color);
+				}
+				break;
+			}
+			case CommandType::DrawCircle: {
+				const auto& [center, radius, color, filled] = _command<DrawCircle>(index);
+				if (filled) {
+					_put_circle_fill(bitmap, clip, center, radius, color);
+				}
+				else {
+					_put_circle(bitmap, clip, center, radius, color);
+				}
+				break;
+			}
+			case CommandType::DrawTriangle: {
+				const auto& [v1, v2, v3, filled] = _command<DrawTriangle>(index);
+				if (filled) {
+					_put_triangle_fill(bitmap, clip, v1, v2, v3, nullptr);
+				}
+				else {
+					_put_triangle(bitmap, clip, v1, v2, v3);
+				}
+				break;
+			}
+			case CommandType::DrawImage: {
+				const auto& [image_id, rect, const_options, palette_copy, transformed] = _command<DrawImage>(index);
+				DrawImageOptions options = const_options;
+				const Image& image = _image(image_id, resources);
+				if (transformed) {
+					_put_image(bitmap, clip, *transformed, rect.pos(), DrawImageOptions { .clip = { 0, 0, transformed->width, transformed->height }, .alpha = options.alpha });
+				}
+				else if (rect.empty()) {
+					if (options.clip.empty()) {
+						options.clip = Rect { 0, 0, image.width, image.height };
+					}
+					_put_image(bitmap, clip, image, rect.pos(), options);
+				}
+				else {
+					_put_image_scaled(bitmap, clip, image, rect, options);
+				}
+				break;
+			}
+			case CommandType::DrawText: {
+				const auto& [font_id, font_size, rect, color, text, options, layout] = _command<DrawText>(index);
+				_put_text(bitmap, clip, *layout, rect.pos(), color, options);
+				break;
+			}
+			case CommandType::DrawTileMap: {
+				const auto& [tilemap_id, camera_offset, caching, version, cache_key] = _command<DrawTileMap>(index);
+				_put_tilemap(bitmap, clip, resources.tilemap(tilemap_id), tilemap_id, IVec2 { -camera_offset.x, -camera_offset.y }, caching);
+				break;
+			}
+			case CommandType::DrawMesh: {
+				const auto& [vertices, indices, image_id, bounds] = _command<DrawMesh>(index);
+				const Image* image = image_id ? &_image(*image_id, resources) : nullptr;
+				_put_mesh(bitmap, clip, m_command_arena.span(vertices), m_command_arena.span(indices), image);
+				break;
+			}
+			case CommandType::DrawPolyline: {
+				const auto& [vertices, bounds] = _command<DrawPolyline>(index);
+				_put_polyline(bitmap, clip, m_command_arena.span(vertices));
+				break;
+			}
+			case CommandType::DrawSprites: {
+				const auto& [sheet, clips, instances, bounds, bins] = _command<DrawSprites>(index);
+				std::optional<std::span<const uint32_t>> binned_instances;
+				if (bins >= 0 && tile >= 0) {
+					const SpriteBins& sprite_bins = m_sprite_bins[bins];
+					const uint32_t start = sprite_bins.tile_starts[tile];
+					binned_instances = std::span<const uint32_t>(sprite_bins.instances).subspan(start, sprite_bins.tile_starts[tile + 1] - start);
+				}
+				_put_sprites(bitmap, clip, _image(sheet, resources), m_command_arena.span(clips), m_command_arena.span(instances), binned_instances);
+				break;
+			}
+		}
 	}
 
-	void Renderer::render(const ResourceManager& resources) {
+	void Renderer::_render_tiled(const ResourceManager& resources) {
 		CPUProfilingScope_Render();
-		TracyPlot("DrawCommands", (int64_t)m_draw_data.size());
-
-		/* Run commands */
-		for (const auto& [command, tag] : m_draw_data) {
+		const Rect screen = { 0, 0, m_bitmap.width(), m_bitmap.height() };
+		const int32_t num_tiles_x = (screen.width + TILE_SIZE - 1) / TILE_SIZE;
+		const int32_t num_tiles_y = (screen.height + TILE_SIZE - 1) / TILE_SIZE;
+		const int32_t num_tiles = num_tiles_x * num_tiles_y;
+
+		/* Bin commands into every tile they overlap */
+		m_tile_commands.resize(num_tiles);
+		for (std::vector<uint32_t>& commands : m_tile_commands) {
+			commands.clear();
+		}
+		for (uint32_t i = 0; i < (uint32_t)m_command_offsets.size(); i++) {
+#ifdef TRACY_ENABLE
+			std::string_view tag = m_command_arena.string(m_command_arena.get<CommandHeader>(m_command_offsets[i]).tag);
 			if (!tag.empty()) {
 				TracyMessage(tag.data(), tag.size());
 			}
-			MATCH_VARIANT(command) {
-				MATCH_CASE(ClearScreen, color) {
-					_clear_screen(&m_bitmap, color);
+#endif
+			Rect bounds = Rect::intersection(_command_bounds(i, resources), screen);
+			if (!bounds.has_area()) {
+				continue;
+			}
+			for (int32_t tile_y = bounds.y / TILE_SIZE; tile_y <= (bounds.y + bounds.height - 1) / TILE_SIZE; tile_y++) {
+				for (int32_t tile_x = bounds.x / TILE_SIZE; tile_x <= (bounds.x + bounds.width - 1) / TILE_SIZE; tile_x++) {
+					m_tile_commands[tile_x + tile_y * num_tiles_x].push_back(i);
 				}
-				MATCH_CASE(DrawPoint, v1) {
-					_put_point(&m_bitmap, v1);
+			}
+		}
+
+		/* Bin sprites into tiles */
+		// Otherwise every tile overlapped by a sprite batch would walk all of its instances
+		_bin_sprites(num_tiles_x, num_tiles_y);
+
+		/* Find dirty tiles */
+		// A tile only needs to be redrawn if the sequence of commands overlapping
+		// it changed since last frame. Otherwise it would end up with the same
+		// pixels it already has.
+		m_dirty_tiles.clear();
+		if (m_dirty_rect_tracking) {
+			const bool had_previous_frame = (int32_t)m_tile_hashes.size() == num_tiles;
+			m_tile_hashes.resize(num_tiles);
+			for (int32_t tile = 0; tile < num_tiles; tile++) {
+				CommandHasher hasher;
+				hasher.add(m_tile_commands[tile].size());
+				for (uint32_t command_index : m_tile_commands[tile]) {
+					hasher.add(m_command_hashes[command_index]);
 				}
-				MATCH_CASE(DrawLine, v1, v2) {
-					_put_line(&m_bitmap, v1, v2, nullptr);
+				const size_t tile_hash = hasher.hash != INVALID_TILE_HASH ? hasher.hash : INVALID_TILE_HASH + 1;
+				if (!had_previous_frame || tile_hash != m_tile_hashes[tile]) {
+					m_dirty_tiles.push_back(tile);
 				}
-				MATCH_CASE(DrawRect, rect, color, filled) {
-					if (filled) {
-						_put_rect_fill(&m_bitmap, rect, color);
-					}
-					else {
-						_put_rect(&m_bitmap, rect, color);
-					}
+				m_tile_hashes[tile] = tile_hash;
+			}
+		}
+		else {
+			for (int32_t tile = 0; tile < num_tiles; tile++) {
+				m_dirty_tiles.push_back(tile);
+			}
+		}
+		TracyPlot("DirtyTiles", (int64_t)m_dirty_tiles.size());
+
+		/* Rasterize tiles */
+		// Tiles don't overlap, so each worker owns the pixels of the tile it
+		// picked and can write to the bitmap without any locking. Running a
+		// tile's commands in submission order gives the same result as the
+		// serial path, since each pixel sees the same sequence of writes.
+		const int32_t num_dirty_tiles = (int32_t)m_dirty_tiles.size();
+		std::atomic<int32_t> next_tile = 0;
+		auto rasterize_tiles = [&]() {
+			for (int32_t i = next_tile++; i < num_dirty_tiles; i = next_tile++) {
+				const int32_t tile = m_dirty_tiles[i];
+				Rect tile_rect = { (tile % num_tiles_x) * TILE_SIZE, (tile / num_tiles_x) * TILE_SIZE, TILE_SIZE, TILE_SIZE };
+				Rect clip = Rect::intersection(tile_rect, screen);
+				for (uint32_t command_index : m_tile_commands[tile]) {
+					_run_command(&m_bitmap, clip, command_index, resources, tile);
 				}
-				MATCH_CASE(DrawCircle, center, radius, color, filled) {
-					if (filled) {
-						_put_circle_fill(&m_bitmap, center, radius, color);
-					}
-					else {
-						_put_circle(&m_bitmap, center, radius, color);
-					}
+			}
+		};
+
+		// NOTE: workers live in a pool between frames, so on_dll_unload() has to
+		// stop them with HOT_RELOAD_stop_render_threads(). Otherwise they would
+		// be executing library code when the DLL gets unloaded during hot reloading.
+		int32_t num_threads = 1;
+		if (m_tiled_rendering) {
+			num_threads = m_num_render_threads > 0 ? m_num_render_threads : (int32_t)std::thread::hardware_concurrency();
+			num_threads = engine::clamp(num_threads, 1, engine::max(num_dirty_tiles, 1));
+		}
+		if (num_threads > 1 && !m_render_threads) {
+			m_render_threads = std::make_unique<WorkerPool>();
+		}
+		if (m_render_threads) {
+			m_render_threads->run(num_threads, rasterize_tiles);
+		}
+		else {
+			rasterize_tiles();
+		}
+
+		_merge_dirty_tiles(num_tiles_x);
+
+		/* Debug draw dirty rects */
+		// The outlines are left in the bitmap, so the tiles under them are
+		// invalidated to get them redrawn next frame.
+		if (m_debug_draw_dirty_rects) {
+			for (Rect rect : m_dirty_rects) {
+				_put_rect(&m_bitmap, screen, rect, Color { 255, 0, 255, 255 });
+			}
+			if (m_dirty_rect_tracking) {
+				for (int32_t tile : m_dirty_tiles) {
+					m_tile_hashes[tile] = INVALID_TILE_HASH;
 				}
-				MATCH_CASE(DrawTriangle, v1, v2, v3, filled) {
-					if (filled) {
-						_put_triangle_fill(&m_bitmap, v1, v2, v3);
-					}
-					else {
-						_put_triangle(&m_bitmap, v1, v2, v3);
+			}
+		}
+	}
+
+	void Renderer::_bin_sprites(int32_t num_tiles_x, int32_t num_tiles_y) {
+		CPUProfilingScope_Render();
+		const Rect screen = { 0, 0, m_bitmap.width(), m_bitmap.height() };
+		const int32_t num_tiles = num_tiles_x * num_tiles_y;
+		size_t num_bins = 0;
+		for (uint32_t offset : m_command_offsets) {
+			const CommandHeader& header = m_command_arena.get<CommandHeader>(offset);
+			if (header.type != CommandType::DrawSprites) {
+				continue;
+			}
+			DrawSprites& draw_sprites = m_command_arena.get<CommandRecord<DrawSprites>>(offset).command;
+			if (num_bins == m_sprite_bins.size()) {
+				m_sprite_bins.emplace_back();
+			}
+			draw_sprites.bins = (int32_t)num_bins;
+			SpriteBins& bins = m_sprite_bins[num_bins++];
+
+			// Calls `visit(instance_index, tile)` for every tile an instance overlaps
+			const Rect clip = Rect::intersection(header.clip, screen);
+			const std::span<const Rect> clips = m_command_arena.span(draw_sprites.clips);
+			const std::span<const SpriteInstance> instances = m_command_arena.span(draw_sprites.instances);
+			auto for_each_overlap = [&](auto visit) {
+				for (uint32_t i = 0; i < (uint32_t)instances.size(); i++) {
+					const SpriteInstance& instance = instances[i];
+					const Rect& src_rect = clips[instance.clip_index];
+					const Rect bounds = Rect::intersection(Rect { instance.pos.x, instance.pos.y, src_rect.width, src_rect.height }, clip);
+					if (!bounds.has_area() || instance.alpha == 0) {
+						continue;
 					}
-				}
-				MATCH_CASE(DrawImage, image_id, rect, const_options) {
-					DrawImageOptions options = const_options;
-					const Image& image = resources.image(image_id);
-					if (rect.empty()) {
-						if (options.clip.empty()) {
-							options.clip = Rect { 0, 0, image.width, image.height };
+					for (int32_t tile_y = bounds.y / TILE_SIZE; tile_y <= (bounds.y + bounds.height - 1) / TILE_SIZE; tile_y++) {
+						for (int32_t tile_x = bounds.x / TILE_SIZE; tile_x <= (bounds.x + bounds.width - 1) / TILE_SIZE; tile_x++) {
+							visit(i, tile_x + tile_y * num_tiles_x);
 						}
-						_put_image(&m_bitmap, image, rect.pos(), options);
-					}
-					else {
-						_put_image_scaled(&m_bitmap, image, rect, options);
 					}
 				}
-				MATCH_CASE(DrawText, font_id, font_size, rect, color, text, options) {
-					const Typeface& font = resources.typeface(font_id);
-					_put_text(&m_bitmap, font, font_size, rect, color, text, options);
-				}
+			};
+
+			/* Count instances per tile, then place them at their tile's start */
+			// Placing bumps each start to the end of its tile, which is the
+			// start of the next one, so the starts are shifted back afterwards.
+			bins.tile_starts.assign(num_tiles + 1, 0);
+			for_each_overlap([&](uint32_t, int32_t tile) { bins.tile_starts[tile + 1]++; });
+			for (int32_t tile = 0; tile < num_tiles; tile++) {
+				bins.tile_starts[tile + 1] += bins.tile_starts[tile];
 			}
+			bins.instances.resize(bins.tile_starts[num_tiles]);
+			for_each_overlap([&](uint32_t instance_index, int32_t tile) { bins.instances[bins.tile_starts[tile]++] = instance_index; });
+			std::copy_backward(bins.tile_starts.begin(), bins.tile_starts.end() - 1, bins.tile_starts.end());
+			bins.tile_starts[0] = 0;
 		}
-		m_draw_data.clear();
 	}
 
-	std::string Renderer::_take_current_tag() {
-		if (!m_current_tag.empty()) {
-			m_last_tag = m_current_tag;
+	void Renderer::_merge_dirty_tiles(int32_t num_tiles_x) {
+		const Rect screen = { 0, 0, m_bitmap.width(), m_bitmap.height() };
+		m_dirty_rects.clear();
+		for (size_t i = 0; i < m_dirty_tiles.size();) {
+			/* Find run of dirty tiles in current row */
+			const int32_t first_tile = m_dirty_tiles[i];
+			int32_t last_tile = first_tile;
+			for (i++; i < m_dirty_tiles.size() && m_dirty_tiles[i] == last_tile + 1 && m_dirty_tiles[i] % num_tiles_x != 0; i++) {
+				last_tile = m_dirty_tiles[i];
+			}
+			const int32_t tile_x = first_tile % num_tiles_x;
+			const int32_t tile_y = first_tile / num_tiles_x;
+			const Rect run = Rect::intersection(Rect { tile_x * TILE_SIZE, tile_y * TILE_SIZE, (last_tile - first_tile + 1) * TILE_SIZE, TILE_SIZE }, screen);
+
+			/* Extend rect from row above if it spans the same columns */
+			bool merged = false;
+			for (Rect& rect : m_dirty_rects) {
+				if (rect.x == run.x && rect.width == run.width && rect.y + rect.height == run.y) {
+					rect.height += run.height;
+					merged = true;
+					break;
+				}
+			}
+			if (!merged) {
+				m_dirty_rects.push_back(run);
+			}
 		}
-		return std::exchange(m_current_tag, std::string());
 	}
 
-	void Renderer::_clear_screen(Bitmap* bitmap, Color color) {
+	void Renderer::_clear_screen(Bitmap* bitmap, Rect clip, Color color) {
 		CPUProfilingScope_Render();
-		bitmap->clear(Pixel::from_color(color));
+		Pixel pixel = Pixel::from_color(color);
+		if (clip.x == 0 && clip.y == 0 && clip.width == bitmap->width() && clip.height == bitmap->height()) {
+			bitmap->clear(pixel);
+			return;
+		}
+		for (int32_t y = clip.y; y < clip.y + clip.height; y++) {
+			bitmap->fill_span(clip.x, y, clip.width, pixel);
+		}
 	}
 
-	void Renderer::_put_point(Bitmap* bitmap, Vertex v1) {
+	void Renderer::_put_point(Bitmap* bitmap, Rect clip, Vertex v1) {
 		CPUProfilingScope_Render();
-		Pixel pixel = { .b = v1.color.b, .g = v1.color.g, .r = v1.color.r, .padding = v1.color.a };
+		if (!clip.contains(v1.pos)) {
+			return;
+		}
+		Pixel pixel = { .b = v1.color.b, .g = v1.color.g, .r = v1.color.r, .a = v1.color.a };
 		bitmap->put(v1.pos.x, v1.pos.y, pixel, v1.color.a / 255.0f);
 	}
 
-	void Renderer::_put_line(Bitmap* bitmap, Vertex v1, Vertex v2, const Image* image) {
+	void Renderer::_put_line(Bitmap* bitmap, Rect clip, Vertex v1, Vertex v2, const Image* image, bool skip_last_point) {
 		CPUProfilingScope_Render();
-		// Bresenham's drawing algorithm
-		// Alois Zingl, 2016, "A Rasterizing Algorithm for Drawing Curves", page 13
-		// https://zingl.github.io/Bresenham.pdf
-		int32_t delta_x = std::abs(v2.pos.x - v1.pos.x);
-		int32_t delta_y = -std::abs(v2.pos.y - v1.pos.y);
-		int32_t sign_x = v1.pos.x < v2.pos.x ? 1 : -1;
-		int32_t sign_y = v1.pos.y < v2.pos.y ? 1 : -1;
-		int32_t error = delta_x + delta_y;
-
-		Vertex cursor = v1;
-		while (true) {
-			/* Put current point */
-			float t = delta_x > 0
-				? ((float)(cursor.pos.x - v1.pos.x) / (float)(v2.pos.x - v1.pos.x))
-				: ((float)(cursor.pos.y - v1.pos.y) / (float)(v2.pos.y - v1.pos.y));
-			if (image) {
-				cursor.color = image->sample(Vec2::lerp(v1.uv, v2.uv, t)) * Color::lerp(v1.color, v2.color, t);
+		// a line is convex, so it's outside the clip rect if its bounds are and inside if both end points are
+		if (!Rect::intersection(bounding_rect({ v1.pos, v2.pos }), clip).has_area()) {
+			return;
+		}
+		if (skip_last_point && v1.pos == v2.pos) {
+			return;
+		}
+		const bool is_inside_clip = clip.contains(v1.pos) && clip.contains(v2.pos);
+		const LineShading shading = image ? LineShading::Textured : (v1.color == v2.color ? LineShading::Solid : LineShading::Gradient);
+
+		/* Solid axis aligned lines are spans */
+		if (shading == LineShading::Solid && (v1.pos.x == v2.pos.x || v1.pos.y == v2.pos.y)) {
+			const IVec2 step = { (v1.pos.x < v2.pos.x) - (v2.pos.x < v1.pos.x), (v1.pos.y < v2.pos.y) - (v2.pos.y < v1.pos.y) };
+			const IVec2 end = skip_last_point ? v2.pos - step : v2.pos;
+			const Rect line = Rect::intersection(bounding_rect({ v1.pos, end }), clip);
+			const Pixel pixel = Pixel::from_color(v1.color);
+			const float alpha = v1.color.a / 255.0f;
+			if (v1.pos.y == v2.pos.y) {
+				bitmap->put_span(line.x, line.y, line.width, pixel, alpha);
 			}
 			else {
-				cursor.color = Color::lerp(v1.color, v2.color, t);
+				for (int32_t y = line.y; y < line.y + line.height; y++) {
+					bitmap->put(line.x, y, pixel, alpha);
+				}
 			}
-			bitmap->put(cursor.pos.x, cursor.pos.y, Pixel::from_color(cursor.color), cursor.color.a / 255.0f);
+			return;
+		}
 
-			/* Step to next point */
-			if (2 * error >= delta_y) {
-				if (cursor.pos.x == v2.pos.x) {
-					break;
-				}
-				error += delta_y;
-				cursor.pos.x += sign_x;
+		/* Skip steps outside of clip rect */
+		// The last step is the end point, unless the line stopped one point short of it
+		int32_t first_step = 0;
+		int32_t last_step = engine::max(std::abs(v2.pos.x - v1.pos.x), std::abs(v2.pos.y - v1.pos.y)) - (skip_last_point ? 1 : 0);
+		if (!is_inside_clip) {
+			std::optional<std::pair<int32_t, int32_t>> visible_steps = visible_line_steps(v1.pos, v2.pos, clip);
+			if (!visible_steps) {
+				return;
 			}
-			if (2 * error <= delta_x) {
-				if (cursor.pos.y == v2.pos.y) {
-					break;
-				}
-				error += delta_x;
-				cursor.pos.y += sign_y;
+			first_step = visible_steps->first;
+			last_step = engine::min(last_step, visible_steps->second);
+			if (first_step > last_step) {
+				return;
 			}
 		}
+
+		LINE_KERNELS[(size_t)shading][is_inside_clip](bitmap, clip, v1, v2, image, first_step, last_step);
 	}
 
-	void Renderer::_put_rect(Bitmap* bitmap, Rect rect, Color color) {
+	void Renderer::_put_rect(Bitmap* bitmap, Rect clip, Rect rect, Color color) {
 		CPUProfilingScope_Render();
 		IVec2 top_left = { rect.x, rect.y };
 		IVec2 top_right = { rect.x + rect.width - 1, rect.y };
@@ -292,247 +2020,461 @@ namespace engine {
 		Vertex right_start = { .pos = top_right + IVec2 { 0, 1 }, .color = color };
 		Vertex right_end = { .pos = bottom_right - IVec2 { 0, 1 }, .color = color };
 
-		_put_line(bitmap, top_start, top_end, nullptr);
-		_put_line(bitmap, bottom_start, bottom_end, nullptr);
-		_put_line(bitmap, left_start, left_end, nullptr);
-		_put_line(bitmap, right_start, right_end, nullptr);
+		_put_line(bitmap, clip, top_start, top_end, nullptr);
+		_put_line(bitmap, clip, bottom_start, bottom_end, nullptr);
+		_put_line(bitmap, clip, left_start, left_end, nullptr);
+		_put_line(bitmap, clip, right_start, right_end, nullptr);
 	}
 
-	void Renderer::_put_rect_fill(Bitmap* bitmap, Rect rect, Color color) {
+	void Renderer::_put_rect_fill(Bitmap* bitmap, Rect clip, Rect rect, Color color) {
 		CPUProfilingScope_Render();
 		Pixel pixel = Pixel::from_color(color);
-		for (int32_t y = rect.y; y < rect.y + rect.height; y++) {
-			for (int32_t x = rect.x; x < rect.x + rect.width; x++) {
-				bitmap->put(x, y, pixel, color.a / 255.0f);
-			}
+		Rect clipped_rect = Rect::intersection(rect, clip);
+		for (int32_t y = clipped_rect.y; y < clipped_rect.y + clipped_rect.height; y++) {
+			bitmap->blend_span(clipped_rect.x, y, clipped_rect.width, pixel, color.a);
 		}
 	}
 
-	void Renderer::_put_circle(Bitmap* bitmap, IVec2 center, int32_t radius, Color color) {
+	void Renderer::_put_circle(Bitmap* bitmap, Rect clip, IVec2 center, int32_t radius, Color color) {
 		CPUProfilingScope_Render();
+		if (radius < 0) {
+			return;
+		}
+		CircleSpans uncached_spans;
+		const CircleSpans& spans = radius <= MAX_CACHED_CIRCLE_RADIUS ? m_circle_spans[radius] : (uncached_spans = _compute_circle_spans(radius));
+
 		Pixel pixel = Pixel::from_color(color);
-		float alpha = color.a / 255.0f;
-		for (IVec2 point : circle_octant_points(radius)) {
-			bitmap->put(center.x + point.x, center.y + point.y, pixel, alpha);
-			bitmap->put(center.x + point.y, center.y + point.x, pixel, alpha);
-			bitmap->put(center.x + point.y, center.y + -point.x, pixel, alpha);
-			bitmap->put(center.x + point.x, center.y + -point.y, pixel, alpha);
-			bitmap->put(center.x + -point.x, center.y + point.y, pixel, alpha);
-			bitmap->put(center.x + -point.y, center.y + point.x, pixel, alpha);
-			bitmap->put(center.x + -point.y, center.y + -point.x, pixel, alpha);
-			bitmap->put(center.x + -point.x, center.y + -point.y, pixel, alpha);
+		auto put_row = [&](int32_t y, int32_t x_start, int32_t x_end) {
+			Rect row = Rect::intersection(Rect { center.x + x_start, y, x_end - x_start + 1, 1 }, clip);
+			if (row.has_area()) {
+				bitmap->blend_span(row.x, y, row.width, pixel, color.a);
+			}
+		};
+		auto put_mirrored_rows = [&](int32_t y, IVec2 outline_row) {
+			if (outline_row.x == 0) {
+				put_row(y, -outline_row.y, outline_row.y);
+			} else {
+				put_row(y, -outline_row.y, -outline_row.x);
+				put_row(y, outline_row.x, outline_row.y);
+			}
+		};
+		// Rows at distance dy from the center lie inside of clip for dy in [first_row, last_row]
+		const int32_t num_rows = (int32_t)spans.outline_rows.size();
+		const int32_t first_row = engine::max(0, engine::max(clip.y - center.y, center.y - (clip.y + clip.height - 1)));
+		const int32_t last_row = engine::min(num_rows - 1, engine::max(clip.y + clip.height - 1 - center.y, center.y - clip.y));
+		for (int32_t dy = first_row; dy <= last_row; dy++) {
+			put_mirrored_rows(center.y + dy, spans.outline_rows[dy]);
+			if (dy != 0) {
+				put_mirrored_rows(center.y - dy, spans.outline_rows[dy]);
+			}
 		}
 	}
 
-	void Renderer::_put_circle_fill(Bitmap* bitmap, IVec2 center, int32_t radius, Color color) {
+	void Renderer::_put_circle_fill(Bitmap* bitmap, Rect clip, IVec2 center, int32_t radius, Color color) {
 		CPUProfilingScope_Render();
-		for (IVec2 point : quarter_circle_points(radius)) {
-			IVec2 bottom_left = center + IVec2 { -point.x, point.y };
-			IVec2 bottom_right = center + IVec2 { point.x, point.y };
-			_put_line(bitmap, Vertex { .pos = bottom_left, .color = color }, Vertex { .pos = bottom_right, .color = color }, nullptr);
+		if (radius < 0) {
+			return;
+		}
+		CircleSpans uncached_spans;
+		const CircleSpans& spans = radius <= MAX_CACHED_CIRCLE_RADIUS ? m_circle_spans[radius] : (uncached_spans = _compute_circle_spans(radius));
 
-			IVec2 top_left = center + IVec2 { -point.x, -point.y };
-			IVec2 top_right = center + IVec2 { point.x, -point.y };
-			if (top_left.y != bottom_left.y) {
-				_put_line(bitmap, Vertex { .pos = top_left, .color = color }, Vertex { .pos = top_right, .color = color }, nullptr);
+		Pixel pixel = Pixel::from_color(color);
+		auto fill_row = [&](int32_t y, int32_t half_width) {
+			Rect row = Rect::intersection(Rect { center.x - half_width, y, 2 * half_width + 1, 1 }, clip);
+			if (row.has_area()) {
+				bitmap->blend_span(row.x, y, row.width, pixel, color.a);
+			}
+		};
+		const int32_t num_rows = (int32_t)spans.half_widths.size();
+		const int32_t first_row = engine::max(0, engine::max(clip.y - center.y, center.y - (clip.y + clip.height - 1)));
+		const int32_t last_row = engine::min(num_rows - 1, engine::max(clip.y + clip.height - 1 - center.y, center.y - clip.y));
+		for (int32_t dy = first_row; dy <= last_row; dy++) {
+			fill_row(center.y + dy, spans.half_widths[dy]);
+			if (dy != 0) {
+				fill_row(center.y - dy, spans.half_widths[dy]);
 			}
 		}
 	}
 
-	void Renderer::_put_triangle(Bitmap* bitmap, Vertex v1, Vertex v2, Vertex v3) {
+	void Renderer::_put_triangle(Bitmap* bitmap, Rect clip, Vertex v1, Vertex v2, Vertex v3) {
 		CPUProfilingScope_Render();
-		_put_line(bitmap, v1, v2, nullptr);
-		_put_line(bitmap, v1, v3, nullptr);
-		_put_line(bitmap, v2, v3, nullptr);
+		_put_line(bitmap, clip, v1, v2, nullptr);
+		_put_line(bitmap, clip, v1, v3, nullptr);
+		_put_line(bitmap, clip, v2, v3, nullptr);
 	}
 
-	void Renderer::_put_triangle_fill(Bitmap* bitmap, Vertex v1, Vertex v2, Vertex v3) {
+	void Renderer::_put_triangle_fill(Bitmap* bitmap, Rect clip, Vertex v1, Vertex v2, Vertex v3, const Image* image) {
 		CPUProfilingScope_Render();
-		auto triangle_area = [](IVec2 a, IVec2 b) -> float {
-			return std::abs((float)(a.x * b.y - a.y * b.x) / 2.0f);
+		/* Set up edge functions */
+		const TriangleEdge edge_12 = TriangleEdge::between(v1.pos, v2.pos);
+		int64_t area = edge_12.evaluate(v3.pos);
+		if (area == 0) {
+			return;
+		}
+		if (area < 0) {
+			std::swap(v2, v3);
+			area = -area;
+		}
+		const TriangleEdge edges[3] = {
+			TriangleEdge::between(v2.pos, v3.pos), // weight of v1
+			TriangleEdge::between(v3.pos, v1.pos), // weight of v2
+			TriangleEdge::between(v1.pos, v2.pos), // weight of v3
 		};
 
-		int32_t x_min = std::min({ v1.pos.x, v2.pos.x, v3.pos.x });
-		int32_t x_max = std::max({ v1.pos.x, v2.pos.x, v3.pos.x });
-		int32_t y_min = std::min({ v1.pos.y, v2.pos.y, v3.pos.y });
-		int32_t y_max = std::max({ v1.pos.y, v2.pos.y, v3.pos.y });
+		const int32_t x_min = std::min({ v1.pos.x, v2.pos.x, v3.pos.x });
+		const int32_t x_max = std::max({ v1.pos.x, v2.pos.x, v3.pos.x });
+		const int32_t y_min = std::min({ v1.pos.y, v2.pos.y, v3.pos.y });
+		const int32_t y_max = std::max({ v1.pos.y, v2.pos.y, v3.pos.y });
+		const Rect bounds = Rect::intersection(Rect { x_min, y_min, x_max - x_min + 1, y_max - y_min + 1 }, clip);
+		if (!bounds.has_area()) {
+			return;
+		}
 
-		float inv_slope[3] = {
-			(float)(v2.pos.x - v1.pos.x) / (float)(v2.pos.y - v1.pos.y),
-			(float)(v3.pos.x - v1.pos.x) / (float)(v3.pos.y - v1.pos.y),
-			(float)(v3.pos.x - v2.pos.x) / (float)(v3.pos.y - v2.pos.y),
-		};
+		/* Set up color interpolation */
+		// Channels are interpolated in 16.16 fixed point, stepping from the left
+		// edge of the unclipped bounds so results don't depend on the clip rect.
+		const bool is_flat_colored = v1.color == v2.color && v1.color == v3.color;
+		const uint8_t Color::* channels[4] = { &Color::r, &Color::g, &Color::b, &Color::a };
+		int64_t channel_step_x[4];
+		for (int32_t i = 0; i < 4; i++) {
+			const uint8_t Color::* channel = channels[i];
+			int64_t step = (int64_t)edges[0].step_x * (v1.color.*channel) + (int64_t)edges[1].step_x * (v2.color.*channel) + (int64_t)edges[2].step_x * (v3.color.*channel);
+			channel_step_x[i] = (step << 16) / area;
+		}
 
-		float area_v1v2v3 = triangle_area(v2.pos - v1.pos, v3.pos - v1.pos);
-		for (int32_t y = y_min; y <= y_max; y++) {
-			/* Get intersections betwen scanline and lines extended from triangle sides */
-			int32_t xs[3] = {
-				(int32_t)std::round((y - v1.pos.y) * inv_slope[0] + v1.pos.x),
-				(int32_t)std::round((y - v1.pos.y) * inv_slope[1] + v1.pos.x),
-				(int32_t)std::round((y - v2.pos.y) * inv_slope[2] + v2.pos.x),
-			};
+		constexpr int32_t CHUNK_SIZE = 64;
+		Color colors[CHUNK_SIZE];
+		const Pixel flat_pixel = Pixel::from_color(v1.color);
+		for (int32_t y = bounds.y; y < bounds.y + bounds.height; y++) {
+			/* Find span of pixel centers inside all edges */
+			const IVec2 row_start = { x_min, y };
+			int64_t span_start = bounds.x;
+			int64_t span_end = bounds.x + bounds.width;
+			int64_t edge_values[3];
+			for (int32_t i = 0; i < 3; i++) {
+				const TriangleEdge& edge = edges[i];
+				edge_values[i] = edge.evaluate(row_start);
+				const int64_t value = edge_values[i] + edge.bias;
+				if (edge.step_x > 0) {
+					span_start = engine::max(span_start, x_min - floor_div(value, edge.step_x));
+				}
+				else if (edge.step_x < 0) {
+					span_end = engine::min(span_end, x_min + floor_div(value, -edge.step_x) + 1);
+				}
+				else if (value < 0) {
+					span_end = span_start;
+				}
+			}
+			if (span_start >= span_end) {
+				continue;
+			}
+
+			/* Fill span */
+			const int32_t span_x = (int32_t)span_start;
+			const int32_t span_length = (int32_t)(span_end - span_start);
+			if (is_flat_colored && !image) {
+				bitmap->blend_span(span_x, y, span_length, flat_pixel, v1.color.a);
+				continue;
+			}
 
-			/* Discard line intersections outside of triangle */
-			if (xs[0] < x_min || xs[0] > x_max) {
-				std::swap(xs[0], xs[2]);
+			int64_t channel_values[4];
+			for (int32_t i = 0; i < 4; i++) {
+				const uint8_t Color::* channel = channels[i];
+				int64_t value = edge_values[0] * (v1.color.*channel) + edge_values[1] * (v2.color.*channel) + edge_values[2] * (v3.color.*channel);
+				channel_values[i] = (value << 16) / area + 0x8000 + (span_x - x_min) * channel_step_x[i];
 			}
-			else if (xs[1] < x_min || xs[1] > x_max) {
-				std::swap(xs[1], xs[2]);
+			for (int32_t chunk_x = 0; chunk_x < span_length; chunk_x += CHUNK_SIZE) {
+				const int32_t chunk_length = engine::min(CHUNK_SIZE, span_length - chunk_x);
+				if (is_flat_colored) {
+					std::fill_n(colors, chunk_length, v1.color);
+				}
+				else {
+					int64_t chunk_values[4];
+					for (int32_t i = 0; i < 4; i++) {
+						chunk_values[i] = channel_values[i] + chunk_x * channel_step_x[i];
+					}
+					interpolate_colors(chunk_values, channel_step_x, chunk_length, colors);
+				}
+				if (image) {
+					// Edge values are barycentric weights scaled by area
+					for (int32_t i = 0; i < chunk_length; i++) {
+						const int64_t x_offset = span_x + chunk_x + i - x_min;
+						const float w1 = (float)(edge_values[0] + x_offset * edges[0].step_x);
+						const float w2 = (float)(edge_values[1] + x_offset * edges[1].step_x);
+						const float w3 = (float)(edge_values[2] + x_offset * edges[2].step_x);
+						const Vec2 uv = (w1 * v1.uv + w2 * v2.uv + w3 * v3.uv) / (float)area;
+						colors[i] = image->sample(Vec2 { engine::clamp(uv.x, 0.0f, 1.0f), engine::clamp(uv.y, 0.0f, 1.0f) }) * colors[i];
+					}
+				}
+				bitmap->blend_span(span_x + chunk_x, y, chunk_length, colors, false);
 			}
-			Vertex p1 = { .pos = { (int32_t)xs[0], y } };
-			Vertex p2 = { .pos = { (int32_t)xs[1], y } };
+		}
+	}
 
-			/* Interpolate colors */
-			float area_v1v2p1 = triangle_area(v2.pos - v1.pos, p1.pos - v1.pos);
-			float area_v1v3p1 = triangle_area(v3.pos - v1.pos, p1.pos - v1.pos);
-			float area_v2v3p1 = triangle_area(v3.pos - v2.pos, p1.pos - v2.pos);
-			float v1_t1 = area_v2v3p1 / area_v1v2v3;
-			float v2_t1 = area_v1v3p1 / area_v1v2v3;
-			float v3_t1 = area_v1v2p1 / area_v1v2v3;
-			p1.color = v1_t1 * v1.color + v2_t1 * v2.color + v3_t1 * v3.color;
+	void Renderer::_put_mesh(Bitmap* bitmap, Rect clip, std::span<const Vertex> vertices, std::span<const uint16_t> indices, const Image* image) {
+		CPUProfilingScope_Render();
+		for (size_t i = 0; i + 2 < indices.size(); i += 3) {
+			_put_triangle_fill(bitmap, clip, vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]], image);
+		}
+	}
 
-			float area_v1v2p2 = triangle_area(v2.pos - v1.pos, p2.pos - v1.pos);
-			float area_v1v3p2 = triangle_area(v3.pos - v1.pos, p2.pos - v1.pos);
-			float area_v2v3p2 = triangle_area(v3.pos - v2.pos, p2.pos - v2.pos);
-			float v1_t2 = area_v2v3p2 / area_v1v2v3;
-			float v2_t2 = area_v1v3p2 / area_v1v2v3;
-			float v3_t2 = area_v1v2p2 / area_v1v2v3;
-			p2.color = v1_t2 * v1.color + v2_t2 * v2.color + v3_t2 * v3.color;
+	void Renderer::_put_polyline(Bitmap* bitmap, Rect clip, std::span<const Vertex> vertices) {
+		CPUProfilingScope_Render();
+		// Lines before the last skip the point they share with the next line, so it's only blended once
+		for (size_t i = 0; i + 1 < vertices.size(); i++) {
+			_put_line(bitmap, clip, vertices[i], vertices[i + 1], nullptr, i + 2 < vertices.size());
+		}
+	}
 
-			/* Draw line */
-			_put_line(bitmap, p1, p2, nullptr);
+	void Renderer::_put_sprites(Bitmap* bitmap, Rect clip, const Image& image, std::span<const Rect> clips, std::span<const SpriteInstance> instances, std::optional<std::span<const uint32_t>> binned_instances) {
+		CPUProfilingScope_Render();
+		uint8_t alpha_table[256];
+		uint8_t table_alpha = 255; // translucent instances tend to come in runs of equal alpha
+		auto put = [&](const SpriteInstance& instance) {
+			const Rect& src_rect = clips[instance.clip_index];
+			const bool is_inside_image = src_rect.x >= 0 && src_rect.y >= 0 && src_rect.x + src_rect.width <= image.width && src_rect.y + src_rect.height <= image.height;
+			DEBUG_ASSERT(is_inside_image, "Sprite clip must lie inside of sheet");
+			if (!is_inside_image || instance.alpha == 0) {
+				return;
+			}
+			if (instance.alpha != 255 && instance.alpha != table_alpha) {
+				fill_alpha_table(instance.alpha / 255.0f, alpha_table);
+				table_alpha = instance.alpha;
+			}
+			put_sprite(bitmap, clip, image, src_rect, instance, alpha_table);
+		};
+		if (binned_instances) {
+			for (uint32_t instance_index : *binned_instances) {
+				put(instances[instance_index]);
+			}
+		}
+		else {
+			for (const SpriteInstance& instance : instances) {
+				put(instance);
+			}
 		}
 	}
 
-	void Renderer::_put_image_scaled(Bitmap* bitmap, const Image& image, Rect rect, DrawImageOptions options) {
+	void Renderer::_put_image_scaled(Bitmap* bitmap, Rect clip, const Image& image, Rect rect, DrawImageOptions options) {
 		CPUProfilingScope_Render();
-		/* UV coordinates */
-		if (options.clip.empty()) {
-			options.clip.width = rect.width;
-			options.clip.height = rect.height;
-		}
-		// bottom left
-		IVec2 clip_bottom_left = { options.clip.x, options.clip.y + options.clip.height - 1 };
-		Vec2 uv0 = {
-			.x = engine::clamp((float)clip_bottom_left.x / (float)(image.width - 1), 0.0f, 1.0f),
-			.y = engine::clamp(1.0f - (float)clip_bottom_left.y / (float)(image.height - 1), 0.0f, 1.0f),
+		const Rect image_rect = { 0, 0, image.width, image.height };
+		const Rect src_rect = options.clip.empty() ? image_rect : Rect::intersection(options.clip, image_rect);
+		const Rect dst_rect = Rect::intersection(rect, clip);
+		if (!src_rect.has_area() || !dst_rect.has_area()) {
+			return;
+		}
+
+		/* Step through source texels in 16.16 fixed point */
+		// Each destination pixel samples the texel under its center, so
+		// integer upscales repeat every texel the same number of times.
+		const IVec2 step = {
+			(int32_t)(((int64_t)src_rect.width << 16) / rect.width),
+			(int32_t)(((int64_t)src_rect.height << 16) / rect.height),
 		};
-		// top right
-		IVec2 clip_top_right = { options.clip.x + options.clip.width - 1, options.clip.y };
-		Vec2 uv1 = {
-			.x = engine::clamp((float)(clip_top_right.x) / (float)(image.width - 1), 0.0f, 1.0f),
-			.y = engine::clamp(1.0f - (float)(clip_top_right.y) / (float)(image.height - 1), 0.0f, 1.0f),
+		auto src_fixed = [](int32_t dst_offset, int32_t dst_length, int32_t step, bool flip) {
+			int32_t offset = flip ? dst_length - 1 - dst_offset : dst_offset;
+			return (int32_t)((int64_t)offset * step + step / 2);
 		};
-
-		/* Draw image line by line */
-		Color color = Color::lerp(Color::white(), options.tint, options.tint.a / 255.0f).with_alpha((uint8_t)(255.0f * options.alpha));
-		for (int32_t y = 0; y < rect.height; y++) {
-			Vertex left = {
-				.pos = { rect.x, rect.y + y },
-				.color = color,
-				.uv = {
-					options.flip_h ? uv1.x : uv0.x,
-					engine::lerp(uv0.y, uv1.y, 1.0f - ((float)y / (float)rect.height)),
-				}
-			};
-			Vertex right = {
-				.pos = { rect.x + rect.width - 1, rect.y + y },
-				.color = color,
-				.uv = {
-					options.flip_h ? uv0.x : uv1.x,
-					engine::lerp(uv0.y, uv1.y, 1.0f - ((float)y / (float)rect.height)),
+		const int32_t src_x_start = src_fixed(dst_rect.x - rect.x, rect.width, step.x, options.flip_h);
+		const int32_t src_x_step = options.flip_h ? -step.x : step.x;
+		int32_t src_y = src_fixed(dst_rect.y - rect.y, rect.height, step.y, options.flip_v);
+		const int32_t src_y_step = options.flip_v ? -step.y : step.y;
+
+		/* Specialize inner loop on tint and alpha */
+		const bool is_tinted = options.tint.a > 0 && options.tint != Color::white();
+		const bool is_translucent = options.alpha != 1.0f;
+		uint8_t alpha_table[256];
+		if (is_translucent) {
+			fill_alpha_table(options.alpha, alpha_table);
+		}
+		const ScaleImageRow scale_row = SCALE_IMAGE_ROW_KERNELS[image_kernel_key(is_tinted, is_translucent, false, false)];
+
+		const AlphaMode alpha_mode = is_translucent ? AlphaMode::Blended : image.alpha_mode;
+		constexpr int32_t CHUNK_SIZE = 64;
+		Pixel pixels[CHUNK_SIZE];
+
+		/* Palette swapped path, look indices up in shaded palette */
+		if (options.palette && image.is_indexed()) {
+			Pixel shaded_colors[Palette::MAX_COLORS];
+			const AlphaMode palette_alpha_mode = shade_palette(*options.palette, image, options.tint, options.alpha, shaded_colors);
+			for (int32_t y = dst_rect.y; y < dst_rect.y + dst_rect.height; y++) {
+				const uint8_t* src_row = &image.indices[src_rect.x + (src_rect.y + (src_y >> 16)) * image.width];
+				for (int32_t chunk_x = 0; chunk_x < dst_rect.width; chunk_x += CHUNK_SIZE) {
+					int32_t chunk_length = engine::min(CHUNK_SIZE, dst_rect.width - chunk_x);
+					int32_t src_x = src_x_start + chunk_x * src_x_step;
+					for (int32_t i = 0; i < chunk_length; i++, src_x += src_x_step) {
+						pixels[i] = shaded_colors[src_row[src_x >> 16]];
+					}
+					bitmap->blend_span(dst_rect.x + chunk_x, y, chunk_length, pixels, palette_alpha_mode, false);
 				}
-			};
-			_put_line(bitmap, left, right, &image);
+				src_y += src_y_step;
+			}
+			return;
 		}
-	}
 
-	void Renderer::_put_image(Bitmap* bitmap, const Image& image, IVec2 pos, DrawImageOptions options) {
-		CPUProfilingScope_Render();
-		int32_t y_end = engine::min(options.clip.height, image.height);
-		int32_t x_end = engine::min(options.clip.width, image.width);
-		for (int32_t y_offset = 0; y_offset < y_end; y_offset++) {
-			for (int32_t x_offset = 0; x_offset < x_end; x_offset++) {
-				Color color = Color::tint(image.get(options.clip.x + x_offset, options.clip.y + y_offset), options.tint);
-				int32_t x = options.flip_h ? pos.x + (options.clip.width - 1 - x_offset) : pos.x + x_offset;
-				int32_t y = options.flip_v ? pos.y + (options.clip.height - 1 - y_offset) : pos.y + y_offset;
-				bitmap->put(x, y, Pixel::from_color(color), color.a / 255.0f * options.alpha);
+		/* Draw image row by row, in chunks */
+		for (int32_t y = dst_rect.y; y < dst_rect.y + dst_rect.height; y++) {
+			const Pixel* src_row = &image.pixels[src_rect.x + (src_rect.y + (src_y >> 16)) * image.width];
+			for (int32_t chunk_x = 0; chunk_x < dst_rect.width; chunk_x += CHUNK_SIZE) {
+				int32_t chunk_length = engine::min(CHUNK_SIZE, dst_rect.width - chunk_x);
+				scale_row(src_row, src_x_start + chunk_x * src_x_step, src_x_step, chunk_length, options.tint, alpha_table, pixels);
+				bitmap->blend_span(dst_rect.x + chunk_x, y, chunk_length, pixels, alpha_mode, false);
 			}
+			src_y += src_y_step;
 		}
 	}
 
-	void Renderer::_put_text(Bitmap* bitmap, const Typeface& font, int32_t font_size, Rect rect, Color color, const std::string& text, DrawTextOptions options) {
-		const int32_t ascent = font.ascent(font_size);
-		const int32_t space_width = font.glyph(font_size, ' ').advance_width;
+	void Renderer::_put_image(Bitmap* bitmap, Rect clip, const Image& image, IVec2 pos, DrawImageOptions options) {
+		CPUProfilingScope_Render();
+		const int32_t y_end = engine::min(options.clip.height, image.height);
+		const int32_t x_end = engine::min(options.clip.width, image.width);
+
+		/* Pre-clip image against destination */
+		// A flipped image is mirrored within its clip rect
+		const IVec2 image_pos = {
+			options.flip_h ? pos.x + (options.clip.width - x_end) : pos.x,
+			options.flip_v ? pos.y + (options.clip.height - y_end) : pos.y,
+		};
+		const Rect dst_rect = Rect::intersection(Rect { image_pos.x, image_pos.y, x_end, y_end }, clip);
+		if (!dst_rect.has_area()) {
+			return;
+		}
 
-		int32_t cursor_x = 0;
-		int32_t cursor_y = ascent;
+		/* Source texel of the top left destination pixel */
+		const IVec2 src_step = { options.flip_h ? -1 : 1, options.flip_v ? -1 : 1 };
+		const IVec2 src_start = {
+			options.clip.x + (options.flip_h ? image_pos.x + x_end - 1 - dst_rect.x : dst_rect.x - image_pos.x),
+			options.clip.y + (options.flip_v ? image_pos.y + y_end - 1 - dst_rect.y : dst_rect.y - image_pos.y),
+		};
 
-		/* Bounding rect defaults */
-		if (rect.width == 0) {
-			rect.width = font.text_width(font_size, text);
+		/* Palette swapped path, look indices up in shaded palette */
+		// Tint and alpha are applied to the palette instead of every pixel
+		constexpr int32_t CHUNK_SIZE = 64;
+		Pixel pixels[CHUNK_SIZE];
+		if (options.palette && image.is_indexed()) {
+			Pixel shaded_colors[Palette::MAX_COLORS];
+			const AlphaMode palette_alpha_mode = shade_palette(*options.palette, image, options.tint, options.alpha, shaded_colors);
+			for (int32_t y = 0; y < dst_rect.height; y++) {
+				for (int32_t chunk_x = 0; chunk_x < dst_rect.width; chunk_x += CHUNK_SIZE) {
+					int32_t chunk_length = engine::min(CHUNK_SIZE, dst_rect.width - chunk_x);
+					IVec2 src_pos = { src_start.x + chunk_x * src_step.x, src_start.y + y * src_step.y };
+					for (int32_t i = 0; i < chunk_length; i++) {
+						pixels[i] = shaded_colors[image.get_index(src_pos.x + i * src_step.x, src_pos.y)];
+					}
+					bitmap->blend_span(dst_rect.x + chunk_x, dst_rect.y + y, chunk_length, pixels, palette_alpha_mode, false);
+				}
+			}
+			return;
 		}
-		if (rect.height == 0) {
-			rect.height = font_size + 1;
+
+		/* Fast path, blend image rows straight into bitmap */
+		// Opaque rows that aren't flipped are copied as is
+		const bool is_tinted = options.tint.a > 0 && options.tint != Color::white();
+		const bool is_translucent = options.alpha != 1.0f;
+		const bool is_inside_image = options.clip.x >= 0 && options.clip.y >= 0 && options.clip.x + x_end <= image.width && options.clip.y + y_end <= image.height;
+		const bool use_runs = is_inside_image && image.has_runs();
+		if (!is_tinted && !is_translucent && is_inside_image && !use_runs) {
+			for (int32_t y = 0; y < dst_rect.height; y++) {
+				const Pixel* src_row = &image.pixels[src_start.x + (src_start.y + y * src_step.y) * image.width];
+				bitmap->blend_span(dst_rect.x, dst_rect.y + y, dst_rect.width, src_row, image.alpha_mode, options.flip_h);
+			}
+			return;
 		}
 
-		/* Render text row-by-row */
-		const std::vector<std::string> words = split_string_into_words(text);
-		auto line_start = words.begin();
-		while (line_start != words.end() && cursor_y < rect.height) {
-			/* Find how many words fit current row */
-			int line_width = 0;
-			auto line_end = line_start;
-			for (; line_end != words.end(); ++line_end) {
-				const std::string& word = *line_end;
-				const int word_width = font.text_width(font_size, word);
-				const int needed_width = (line_width > 0 ? line_width + space_width : line_width) + word_width;
-				if (needed_width > rect.width) {
-					break;
-				}
-				line_width = needed_width;
-			}
-
-			/* Compute word position based on alignment */
-			const int row_remainder = rect.width - line_width;
-			switch (options.h_alignment) {
-				case HorizontalAlignment::Left: cursor_x = 0; break;
-				case HorizontalAlignment::Center: cursor_x = row_remainder / 2; break;
-				case HorizontalAlignment::Right: cursor_x = row_remainder; break;
-			}
-
-			/* Put all words in current row */
-			for (auto it = line_start; it != line_end; ++it) {
-				const std::string& word = *it;
-				for (char character : word) {
-					/* Render character */
-					const engine::Glyph& glyph = font.glyph(font_size, character);
-					for (int32_t y = 0; y < glyph.height; y++) {
-						for (int32_t x = 0; x < glyph.width; x++) {
-							engine::Pixel pixel = engine::Pixel::from_color(color);
-							float alpha = (glyph.get(x, y) / 255.0f) * (color.a / 255.0f);
-							int32_t pixel_x = rect.x + cursor_x + glyph.left_side_bearing + x;
-							int32_t pixel_y = rect.y + cursor_y + y + glyph.y_offset;
-							bitmap->put(pixel_x, pixel_y, pixel, alpha);
-						}
+		/* Specialize shading on tint and alpha */
+		uint8_t alpha_table[256];
+		if (is_translucent) {
+			fill_alpha_table(options.alpha, alpha_table);
+		}
+		const ShadeImageRow shade_row = SHADE_IMAGE_ROW_KERNELS[image_kernel_key(is_tinted, is_translucent, options.flip_h, !is_inside_image)];
+		const AlphaMode alpha_mode = is_translucent ? AlphaMode::Blended : image.alpha_mode;
+
+		/* Run-length encoded path, only visit visible pixels */
+		if (use_runs) {
+			const int32_t src_x_min = options.flip_h ? src_start.x - dst_rect.width + 1 : src_start.x;
+			const int32_t src_x_max = src_x_min + dst_rect.width;
+			for (int32_t y = 0; y < dst_rect.height; y++) {
+				const int32_t src_y = src_start.y + y * src_step.y;
+				const Pixel* src_row = &image.pixels[src_y * image.width];
+				std::span<const ImageRun> runs = image.runs_in_row(src_y);
+				auto run = std::partition_point(runs.begin(), runs.end(), [&](const ImageRun& candidate) { return candidate.x + candidate.length <= src_x_min; });
+				for (; run != runs.end() && run->x < src_x_max; ++run) {
+					const int32_t start = engine::max<int32_t>(run->x, src_x_min);
+					const int32_t end = engine::min<int32_t>(run->x + run->length, src_x_max);
+					const int32_t dst_x = options.flip_h ? dst_rect.x + src_start.x - (end - 1) : dst_rect.x + start - src_start.x;
+					if (!is_tinted && !is_translucent) {
+						const Pixel* src_pixels = options.flip_h ? src_row + end - 1 : src_row + start;
+						bitmap->blend_span(dst_x, dst_rect.y + y, end - start, src_pixels, run->alpha_mode, options.flip_h);
+						continue;
+					}
+					const AlphaMode run_alpha_mode = is_translucent ? AlphaMode::Blended : run->alpha_mode;
+					for (int32_t chunk_x = 0; chunk_x < end - start; chunk_x += CHUNK_SIZE) {
+						int32_t chunk_length = engine::min(CHUNK_SIZE, end - start - chunk_x);
+						int32_t src_x = options.flip_h ? end - 1 - chunk_x : start + chunk_x;
+						shade_row(src_row, image.width, src_x, chunk_length, options.tint, alpha_table, pixels);
+						bitmap->blend_span(dst_x + chunk_x, dst_rect.y + y, chunk_length, pixels, run_alpha_mode, false);
 					}
-
-					/* Go to next column */
-					cursor_x += glyph.advance_width;
 				}
+			}
+			return;
+		}
+
+		/* General path, shade image rows in chunks */
+		for (int32_t y = 0; y < dst_rect.height; y++) {
+			const int32_t src_y = engine::clamp(src_start.y + y * src_step.y, 0, image.height - 1);
+			const Pixel* src_row = &image.pixels[src_y * image.width];
+			for (int32_t chunk_x = 0; chunk_x < dst_rect.width; chunk_x += CHUNK_SIZE) {
+				int32_t chunk_length = engine::min(CHUNK_SIZE, dst_rect.width - chunk_x);
+				shade_row(src_row, image.width, src_start.x + chunk_x * src_step.x, chunk_length, options.tint, alpha_table, pixels);
+				bitmap->blend_span(dst_rect.x + chunk_x, dst_rect.y + y, chunk_length, pixels, alpha_mode, false);
+			}
+		}
+	}
 
-				/* Add space between words */
-				cursor_x += space_width;
+	void Renderer::_put_tilemap(Bitmap* bitmap, Rect clip, const TileMap& tilemap, TileMapID tilemap_id, IVec2 pos, TileMapCaching caching) {
+		CPUProfilingScope_Render();
+		if (caching == TileMapCaching::ScrollBuffer) {
+			if (auto it = m_tilemap_scroll_buffers.find(tilemap_id.value); it != m_tilemap_scroll_buffers.end()) {
+				it->second.buffer.draw(bitmap, clip);
 			}
+			return;
+		}
+
+		auto it = m_tilemap_chunks.find(tilemap_id.value);
+		if (it == m_tilemap_chunks.end()) {
+			return;
+		}
 
-			/* Advance to next row */
-			cursor_y += ascent;
-			line_start = line_end;
+		/* Blit chunks inside of clip rect, rendered at start of render() */
+		// Opaque chunks are copied row by row
+		const IVec2 num_chunks = tilemap.num_chunks();
+		const IVec2 chunk_pixel_size = TileMap::CHUNK_SIZE * tilemap.tile_size();
+		const Rect visible = Rect::intersection(Rect { pos.x, pos.y, tilemap.pixel_size().x, tilemap.pixel_size().y }, clip);
+		if (!visible.has_area() || chunk_pixel_size.x <= 0 || chunk_pixel_size.y <= 0) {
+			return;
+		}
+		const IVec2 first_chunk = { (visible.x - pos.x) / chunk_pixel_size.x, (visible.y - pos.y) / chunk_pixel_size.y };
+		const IVec2 last_chunk = { (visible.x + visible.width - 1 - pos.x) / chunk_pixel_size.x, (visible.y + visible.height - 1 - pos.y) / chunk_pixel_size.y };
+		for (int32_t chunk_y = first_chunk.y; chunk_y <= last_chunk.y; chunk_y++) {
+			for (int32_t chunk_x = first_chunk.x; chunk_x <= last_chunk.x; chunk_x++) {
+				const Image& chunk_image = it->second.chunks[chunk_x + (size_t)chunk_y * num_chunks.x].image;
+				const IVec2 chunk_pos = { pos.x + chunk_x * chunk_pixel_size.x, pos.y + chunk_y * chunk_pixel_size.y };
+				if (chunk_image.pixels.empty() || !Rect::intersection(Rect { chunk_pos.x, chunk_pos.y, chunk_image.width, chunk_image.height }, clip).has_area()) {
+					continue;
+				}
+				_put_image(bitmap, clip, chunk_image, chunk_pos, DrawImageOptions { .clip = { 0, 0, chunk_image.width, chunk_image.height } });
+			}
 		}
+	}
+
+	void Renderer::_put_text(Bitmap* bitmap, Rect clip, const TextLayout& layout, IVec2 pos, Color color, DrawTextOptions options) {
+		/* Blit glyphs */
+		const PutGlyphs put_glyphs = color.a == 255 ? &put_glyph_rows<true> : &put_glyph_rows<false>;
+		put_glyphs(bitmap, clip, layout, pos, color);
 
 		/* Debug render bounding rect */
 		if (options.debug_draw_box) {
-			_put_rect(bitmap, rect, Color::green());
+			_put_rect(bitmap, clip, Rect { pos.x, pos.y, layout.size.x, layout.size.y }, Color::green());
 		}
 	}
 
@@ -1,27 +1,42 @@
 #pragma once
 
+#include <engine/container/linear_arena.h>
+#include <engine/container/radix_sort.h>
 #include <engine/debug/filename_from_path.h>
 #include <engine/graphics/bitmap.h>
 #include <engine/graphics/color.h>
 #include <engine/graphics/font_id.h>
 #include <engine/graphics/image_id.h>
 #include <engine/graphics/rect.h>
+#include <engine/graphics/scroll_buffer.h>
+#include <engine/graphics/text_layout.h>
+#include <engine/graphics/tilemap_id.h>
+#include <engine/graphics/transformed_image_cache.h>
 #include <engine/math/ivec2.h>
+#include <engine/utility/worker_pool.h>
 
 #include <format>
-#include <string>
-#include <variant>
+#include <memory>
+#include <optional>
+#include <span>
+#include <string_view>
+#include <unordered_map>
 #include <vector>
 
-// Adds a tag to the renderer for the current file and line
+// Adds a tag to the renderer for the current file and line, compiled out when not profiling
+#ifdef TRACY_ENABLE
 #define RENDERER_LOG(renderer, message) \
 	(renderer)->add_tag(std::format("{}:{}: {}", engine::filename_from_path(__FILE__), __LINE__, message))
+#else
+#define RENDERER_LOG(renderer, message) ((void)0)
+#endif
 
 namespace engine {
 
 	class ResourceManager;
+	class TileMap;
 	struct Image;
-	class Typeface;
+	struct Palette;
 
 	struct Vertex {
 		IVec2 pos;
@@ -36,12 +51,25 @@ namespace engine {
 		bool flip_v = false;
 		float alpha = 1.0f;
 		Color tint = Color::white();
+		const Palette* palette = nullptr; // swaps the colors of indexed images, copied when recorded
 	};
 
-	enum class HorizontalAlignment {
-		Left,
-		Center,
-		Right,
+	enum SpriteFlags : uint8_t {
+		SPRITE_FLIP_H = 1 << 0,
+		SPRITE_FLIP_V = 1 << 1,
+	};
+
+	// One sprite drawn by draw_sprites(), kept small since there can be thousands per frame
+	struct SpriteInstance {
+		IVec2 pos;
+		uint16_t clip_index; // into the clips given to set_sprite_clips() for the sheet
+		uint8_t flags = 0; // SpriteFlags
+		uint8_t alpha = 255;
+	};
+
+	enum class TileMapCaching : uint8_t {
+		Chunks, // pre-rendered chunks, for tile maps that rarely move
+		ScrollBuffer, // wrap-around buffer under the screen, for backgrounds that scroll every frame
 	};
 
 	struct DrawTextOptions {
@@ -55,7 +83,53 @@ namespace engine {
 		static Renderer with_bitmap(int32_t width, int32_t height);
 
 		// tags next draw command, shows up in Tracy
-		void add_tag(std::string tag);
+		void add_tag(std::string_view tag);
+
+		// Sets the draw order of following commands until the end of the frame.
+		// Commands are drawn by ascending layer, then by ascending depth (e.g. the
+		// y position of characters in a top-down view). Images with the same layer
+		// and depth are grouped by image, other commands keep submission order.
+		// Commands drawn before any call end up on layer 0.
+		void set_draw_layer(int16_t layer);
+		void set_draw_layer(int16_t layer, int16_t depth);
+
+		// Restricts following commands to `rect`, intersected with the enclosing clip rect.
+		// Commands that fall entirely outside of the active clip rect are dropped when recorded.
+		void push_clip_rect(Rect rect);
+		void pop_clip_rect();
+
+		// Offscreen bitmap that draw commands can be directed into, and that is drawn
+		// like any other image by passing the returned id to draw_image(). Targets keep
+		// their pixels between frames, so static content only has to be drawn once.
+		// They're opaque like the screen, so clear them to what they'll be drawn over.
+		ImageID create_render_target(int32_t width, int32_t height);
+
+		// Directs following commands into `target` until end_render_target(). Targets are
+		// drawn before the screen, in the order they were created.
+		void begin_render_target(ImageID target);
+		void end_render_target();
+
+		// Opt-in: rasterize commands in 32x32 pixel tiles spread out over worker threads.
+		// A `num_threads` of 0 means one thread per hardware core.
+		void set_tiled_rendering(bool enabled, int32_t num_threads = 0);
+		// Joins the worker threads, which are otherwise kept between frames, so that none
+		// of them is running library code when it's unloaded. The next frame restarts them.
+		void HOT_RELOAD_stop_render_threads();
+
+		// Opt-in: only rasterize the 32x32 pixel tiles whose draw commands differ from
+		// last frame and keep the rest of the bitmap as is. Assumes every frame draws
+		// over the whole screen, e.g. by starting with clear_screen().
+		void set_dirty_rect_tracking(bool enabled);
+		void set_debug_draw_dirty_rects(bool enabled);
+
+		// Opt-in: skip rasterizing a frame when its sorted draw commands, and the versions
+		// of the render targets and tile maps they use, hash the same as last frame's. The
+		// bitmap keeps last frame's pixels, and dirty_rects() is empty. Render targets are
+		// skipped the same way. Assumes every frame draws over the whole screen.
+		void set_frame_skipping(bool enabled);
+
+		// Memory kept for flipped and tinted copies of images drawn unscaled, 0 disables the cache
+		void set_transformed_image_budget(size_t bytes);
 
 		void clear_screen(Color color = { 0, 0, 0, 255 });
 		void draw_point(Vertex v1);
@@ -67,89 +141,286 @@ namespace engine {
 		void draw_circle_fill(IVec2 center, int32_t radius, Color color);
 		void draw_triangle(Vertex v1, Vertex v2, Vertex v3);
 		void draw_triangle_fill(Vertex v1, Vertex v2, Vertex v3);
+
+		// Draws filled triangles between `vertices`, three indices per triangle, as a
+		// single command. When given an image, it's sampled at the vertices' uvs and
+		// multiplied by their colors. Meshes with indices out of range are logged as a
+		// warning and not drawn.
+		void draw_mesh(std::span<const Vertex> vertices, std::span<const uint16_t> indices, std::optional<ImageID> image_id = {});
+		// Draws lines between consecutive vertices as a single command, with the
+		// points shared by consecutive lines drawn once
+		void draw_polyline(std::span<const Vertex> vertices);
 		void draw_image(ImageID image_id, IVec2 pos, DrawImageOptions options = {});
 		void draw_image_scaled(ImageID image_id, Rect rect, DrawImageOptions options = {});
-		void draw_text(FontID font_id, int32_t font_size, Rect rect, Color color, std::string text, DrawTextOptions options = {});
+		void draw_text(FontID font_id, int32_t font_size, Rect rect, Color color, std::string_view text, DrawTextOptions options = {});
+
+		// Clip rects inside of `sheet` that sprite instances refer to by index. They're
+		// kept until set again, so set them up once instead of every frame.
+		void set_sprite_clips(ImageID sheet, std::span<const Rect> clips);
+		// Draws a clip of `sheet` per instance, in order, as a single command. Made for
+		// particles and crowds, so unlike draw_image() sprites can't be tinted or scaled.
+		// The clips are copied when recorded. Instances with a clip index out of range
+		// drop the whole command.
+		void draw_sprites(ImageID sheet, std::span<const SpriteInstance> instances);
+
+		// Draws tile map with its top left corner at `-camera_offset`. Tiles are
+		// pre-rendered, and only rendered again when changed or newly scrolled in.
+		// A tile map has one scroll buffer, so draw it at most once per frame with it.
+		void draw_tilemap(TileMapID tilemap_id, IVec2 camera_offset, TileMapCaching caching = TileMapCaching::Chunks);
 
 		const Bitmap& bitmap();
 		IVec2 screen_resolution() const;
+		const TextLayoutCache& text_layout_cache() const;
+		const TransformedImageCache& transformed_image_cache() const;
+
+		// Regions of the bitmap written by the last render(), the whole screen unless tracking dirty rects
+		const std::vector<Rect>& dirty_rects() const;
+		int64_t num_skipped_frames() const; // frames left as is by frame skipping
 
 		void render(const ResourceManager& resources);
 
 	private:
+		enum class CommandType : uint8_t {
+			ClearScreen,
+			DrawPoint,
+			DrawLine,
+			DrawRect,
+			DrawCircle,
+			DrawTriangle,
+			DrawImage,
+			DrawText,
+			DrawTileMap,
+			DrawMesh,
+			DrawPolyline,
+			DrawSprites,
+		};
 		struct ClearScreen {
+			static constexpr CommandType TYPE = CommandType::ClearScreen;
 			Color color;
 		};
 		struct DrawPoint {
+			static constexpr CommandType TYPE = CommandType::DrawPoint;
 			Vertex v1;
 		};
 		struct DrawLine {
+			static constexpr CommandType TYPE = CommandType::DrawLine;
 			Vertex v1;
 			Vertex v2;
 		};
 		struct DrawRect {
+			static constexpr CommandType TYPE = CommandType::DrawRect;
 			Rect rect;
 			Color color;
 			bool filled;
 		};
 		struct DrawCircle {
+			static constexpr CommandType TYPE = CommandType::DrawCircle;
 			IVec2 center;
 			int32_t radius;
 			Color color;
 			bool filled;
 		};
 		struct DrawTriangle {
+			static constexpr CommandType TYPE = CommandType::DrawTriangle;
 			Vertex v1;
 			Vertex v2;
 			Vertex v3;
 			bool filled;
 		};
 		struct DrawImage {
+			static constexpr CommandType TYPE = CommandType::DrawImage;
 			ImageID image_id;
 			Rect rect;
-			DrawImageOptions options;
+			DrawImageOptions options; // palette points into palette_copy once render() starts
+			ArenaSpan<Palette> palette_copy;
+			const Image* transformed; // cached flipped and tinted copy, looked up at start of render()
 		};
 		struct DrawText {
+			static constexpr CommandType TYPE = CommandType::DrawText;
 			FontID font_id;
 			int32_t font_size;
 			Rect rect;
 			Color color;
-			std::string text;
+			ArenaString text;
 			DrawTextOptions options;
+			const TextLayout* layout; // looked up at start of render()
+		};
+		// What a tile map's cached pixels were made from, besides its tiles
+		struct TileMapCacheKey {
+			uint64_t tilemap_identity; // changes when the tile map is replaced in place
+			ImageID tileset;
+			uint32_t tileset_version; // of a render target tileset, 0 for other images
+			IVec2 tile_size;
+			IVec2 size; // in tiles
+			bool operator==(const TileMapCacheKey& rhs) const = default;
+		};
+		struct DrawTileMap {
+			static constexpr CommandType TYPE = CommandType::DrawTileMap;
+			TileMapID tilemap_id;
+			IVec2 camera_offset;
+			TileMapCaching caching;
+			uint32_t version; // of tile map, looked up at start of render()
+			TileMapCacheKey cache_key; // looked up along with version
+		};
+		struct DrawMesh {
+			static constexpr CommandType TYPE = CommandType::DrawMesh;
+			ArenaSpan<Vertex> vertices;
+			ArenaSpan<uint16_t> indices;
+			std::optional<ImageID> image_id;
+			Rect bounds; // of vertices, computed when recorded
+		};
+		struct DrawPolyline {
+			static constexpr CommandType TYPE = CommandType::DrawPolyline;
+			ArenaSpan<Vertex> vertices;
+			Rect bounds; // of vertices, computed when recorded
+		};
+		struct DrawSprites {
+			static constexpr CommandType TYPE = CommandType::DrawSprites;
+			ImageID sheet;
+			ArenaSpan<Rect> clips; // copy of the sheet's clips when recorded
+			ArenaSpan<SpriteInstance> instances;
+			Rect bounds; // of instances, computed when recorded
+			int32_t bins; // into m_sprite_bins, filled in when rendering tiles, -1 otherwise
 		};
-		using DrawCommand = std::variant<
-			ClearScreen,
-			DrawPoint,
-			DrawLine,
-			DrawRect,
-			DrawCircle,
-			DrawTriangle,
-			DrawImage,
-			DrawText>;
 
-		struct DrawData {
-			DrawCommand command;
-			std::string tag; // meta data for what's being drawn
+		// Commands are plain structs recorded back to back in an arena, each behind a header
+		struct CommandHeader {
+			CommandType type;
+			ArenaString tag; // meta data for what's being drawn, only recorded when profiling
+			Rect clip; // clip rect active when recorded
+		};
+		template <typename T>
+		struct CommandRecord {
+			CommandHeader header;
+			T command;
+		};
+
+		struct RenderTarget {
+			Bitmap bitmap;
+			Image image; // copy of bitmap for image draws, updated when drawn into
+			uint32_t version; // bumped when drawn into, so dirty tiles notice the new pixels
+			std::vector<uint32_t> command_offsets; // into m_command_arena, recorded this frame
+			std::vector<uint64_t> command_keys;
+			std::optional<size_t> commands_hash; // of the commands last drawn into it, when frame skipping
+		};
+
+		struct TileMapChunk {
+			Image image; // empty until the chunk is first drawn
+			uint32_t version; // of the tile map chunk rendered into image
+			int64_t last_drawn_frame;
+		};
+		struct TileMapChunks {
+			TileMapCacheKey key; // chunks are dropped when it changes
+			std::vector<TileMapChunk> chunks; // row by row
+		};
+		struct TileMapScrollBuffer {
+			TileMapCacheKey key; // buffer is dropped when it changes
+			ScrollBuffer buffer;
+			int64_t last_drawn_frame;
+		};
+
+		// Instances of a sprite command binned by tile, so that each tile only
+		// visits the sprites overlapping it
+		struct SpriteBins {
+			std::vector<uint32_t> tile_starts; // into instances, per tile and one past the last tile
+			std::vector<uint32_t> instances; // indices into the command's instances, in draw order
+		};
+
+		struct CircleSpans {
+			std::vector<IVec2> outline_rows; // per row first and last distance from center, for outlines
+			std::vector<int32_t> half_widths; // per row distance from center, for fills
 		};
 
 		Bitmap m_bitmap;
-		std::string m_last_tag; // for debuggin
-		std::string m_current_tag;
-		std::vector<DrawData> m_draw_data;
-
-		std::string _take_current_tag();
-		void _clear_screen(Bitmap* bitmap, Color color);
-		void _put_point(Bitmap* bitmap, Vertex v1);
-		void _put_line(Bitmap* bitmap, Vertex v1, Vertex v2, const Image* image);
-		void _put_rect(Bitmap* bitmap, Rect rect, Color color);
-		void _put_rect_fill(Bitmap* bitmap, Rect rect, Color color);
-		void _put_circle(Bitmap* bitmap, IVec2 center, int32_t radius, Color color);
-		void _put_circle_fill(Bitmap* bitmap, IVec2 center, int32_t radius, Color color);
-		void _put_triangle(Bitmap* bitmap, Vertex v1, Vertex v2, Vertex v3);
-		void _put_triangle_fill(Bitmap* bitmap, Vertex v1, Vertex v2, Vertex v3);
-		void _put_image(Bitmap* bitmap, const Image& image, IVec2 pos, DrawImageOptions options);
-		void _put_image_scaled(Bitmap* bitmap, const Image& image, Rect rect, DrawImageOptions options);
-		void _put_text(Bitmap* bitmap, const Typeface& typeface, int32_t font_size, Rect rect, Color color, const std::string& text, DrawTextOptions options);
+		ArenaString m_current_tag;
+		LinearArena m_command_arena; // reset every frame
+		std::vector<uint32_t> m_command_offsets; // into m_command_arena, in submission order until sorted by render()
+		std::vector<uint64_t> m_command_keys; // sort key per command
+		RadixSorter m_command_sorter;
+		int16_t m_draw_layer = 0;
+		std::optional<int16_t> m_draw_depth;
+		std::vector<Rect> m_clip_rects; // innermost last, each already intersected with the ones below
+
+		std::vector<RenderTarget> m_render_targets; // ImageID -1 is the first target, -2 the second, ...
+		std::optional<size_t> m_active_render_target; // commands go to the screen when empty
+
+		bool m_tiled_rendering = false;
+		int32_t m_num_render_threads = 0;
+		std::unique_ptr<WorkerPool> m_render_threads; // started by the first multithreaded frame
+		std::vector<std::vector<uint32_t>> m_tile_commands; // indices into m_command_offsets, per tile
+
+		bool m_dirty_rect_tracking = false;
+		bool m_debug_draw_dirty_rects = false;
+		std::vector<size_t> m_command_hashes; // per command this frame, when tracking dirty rects or skipping frames
+		std::vector<size_t> m_tile_hashes; // hash of the commands overlapping each tile last frame
+		std::vector<int32_t> m_dirty_tiles; // in ascending order
+		std::vector<Rect> m_dirty_rects;
+
+		bool m_frame_skipping = false;
+		std::optional<size_t> m_frame_hash; // of the commands last drawn into the screen
+		int64_t m_num_skipped_frames = 0;
+
+		// indexed by radius, filled in when circles are drawn so rasterizers can read it from any thread
+		std::vector<CircleSpans> m_circle_spans;
+
+		TextLayoutCache m_text_layouts;
+		std::vector<std::shared_ptr<const TextLayout>> m_frame_text_layouts; // keeps layouts used this frame alive
+
+		TransformedImageCache m_transformed_images;
+		std::vector<std::shared_ptr<const Image>> m_frame_transformed_images; // keeps images used this frame alive
+
+		std::unordered_map<int, TileMapChunks> m_tilemap_chunks; // per TileMapID
+		std::unordered_map<int, TileMapScrollBuffer> m_tilemap_scroll_buffers; // per TileMapID
+		int64_t m_frame = 0;
+
+		std::unordered_map<int, std::vector<Rect>> m_sprite_clips; // per ImageID of sprite sheet
+		std::vector<SpriteBins> m_sprite_bins; // reused between frames to keep their memory
+
+		template <typename T>
+		void _push_command(const T& command);
+		template <typename T>
+		const T& _command(uint32_t index) const;
+		Rect _target_rect() const;
+		const Image& _image(ImageID image_id, const ResourceManager& resources) const;
+		void _draw_image(ImageID image_id, Rect rect, DrawImageOptions options);
+		void _look_up_palettes(std::span<const uint32_t> command_offsets);
+		void _render_targets(const ResourceManager& resources);
+		template <typename T>
+		Rect _recorded_bounds(const T& command) const;
+		Rect _command_bounds(uint32_t index, const ResourceManager& resources) const;
+		Rect _opaque_bounds(uint32_t index, const ResourceManager& resources) const;
+		void _cull_occluded_commands(const ResourceManager& resources);
+		size_t _command_hash(uint32_t index) const;
+		size_t _hash_commands();
+		void _run_command(Bitmap* bitmap, Rect clip, uint32_t index, const ResourceManager& resources, int32_t tile = -1);
+		void _render_tiled(const ResourceManager& resources);
+		void _bin_sprites(int32_t num_tiles_x, int32_t num_tiles_y);
+		void _merge_dirty_tiles(int32_t num_tiles_x);
+		void _layout_text(const ResourceManager& resources);
+		void _transform_images(const ResourceManager& resources);
+		void _look_up_tilemap_versions(const ResourceManager& resources);
+		void _render_tilemap_chunks(const ResourceManager& resources);
+		void _evict_tilemap_chunks();
+		static CircleSpans _compute_circle_spans(int32_t radius);
+		void _cache_circle_spans(int32_t radius);
+
+		// Rasterizers only write pixels inside of `clip`
+		void _clear_screen(Bitmap* bitmap, Rect clip, Color color);
+		void _put_point(Bitmap* bitmap, Rect clip, Vertex v1);
+		void _put_line(Bitmap* bitmap, Rect clip, Vertex v1, Vertex v2, const Image* image, bool skip_last_point = false);
+		void _put_rect(Bitmap* bitmap, Rect clip, Rect rect, Color color);
+		void _put_rect_fill(Bitmap* bitmap, Rect clip, Rect rect, Color color);
+		void _put_circle(Bitmap* bitmap, Rect clip, IVec2 center, int32_t radius, Color color);
+		void _put_circle_fill(Bitmap* bitmap, Rect clip, IVec2 center, int32_t radius, Color color);
+		void _put_triangle(Bitmap* bitmap, Rect clip, Vertex v1, Vertex v2, Vertex v3);
+		void _put_triangle_fill(Bitmap* bitmap, Rect clip, Vertex v1, Vertex v2, Vertex v3, const Image* image);
+		void _put_mesh(Bitmap* bitmap, Rect clip, std::span<const Vertex> vertices, std::span<const uint16_t> indices, const Image* image);
+		void _put_polyline(Bitmap* bitmap, Rect clip, std::span<const Vertex> vertices);
+		void _put_image(Bitmap* bitmap, Rect clip, const Image& image, IVec2 pos, DrawImageOptions options);
+		void _put_sprites(Bitmap* bitmap, Rect clip, const Image& image, std::span<const Rect> clips, std::span<const SpriteInstance> instances, std::optional<std::span<const uint32_t>> binned_instances);
+		void _put_image_scaled(Bitmap* bitmap, Rect clip, const Image& image, Rect rect, DrawImageOptions options);
+		void _put_text(Bitmap* bitmap, Rect clip, const TextLayout& layout, IVec2 pos, Color color, DrawTextOptions options);
+		void _put_tilemap(Bitmap* bitmap, Rect clip, const TileMap& tilemap, TileMapID tilemap_id, IVec2 pos, TileMapCaching caching);
 	};
 
 } // namespace engine
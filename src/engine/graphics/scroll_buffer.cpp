@@ -0,0 +1,155 @@
+#include <engine/graphics/scroll_buffer.h>
+
+#include <engine/graphics/bitmap.h>
+#include <engine/graphics/image.h>
+#include <engine/graphics/tilemap.h>
+#include <engine/math/math.h>
+
+#include <algorithm>
+
+namespace engine {
+
+	// Rounds towards negative infinity, unlike integer division
+	static int32_t floor_div(int32_t value, int32_t divisor) {
+		int32_t quotient = value / divisor;
+		return (value % divisor != 0 && (value < 0) != (divisor < 0)) ? quotient - 1 : quotient;
+	}
+
+	static int32_t wrap(int32_t value, int32_t size) {
+		int32_t remainder = value % size;
+		return remainder < 0 ? remainder + size : remainder;
+	}
+
+	void ScrollBuffer::update(const TileMap& tilemap, const Image& tileset, IVec2 pos, Rect view) {
+		m_num_copied_tiles = 0;
+		const IVec2 tile_size = tilemap.tile_size();
+		if (!view.has_area() || tile_size.x <= 0 || tile_size.y <= 0) {
+			m_view = {};
+			return;
+		}
+
+		/* Start over when the buffer no longer fits */
+		const bool has_same_layout = m_tileset == tilemap.tileset() && m_tile_size == tile_size
+			&& m_view.width == view.width && m_view.height == view.height
+			&& m_chunk_versions.size() == (size_t)tilemap.num_chunks().x * tilemap.num_chunks().y;
+		if (!has_same_layout) {
+			_reset(tilemap, view);
+		}
+		m_view = view;
+		m_camera = view.pos() - pos;
+
+		/* Find tiles under view */
+		const IVec2 first_tile = { floor_div(m_camera.x, tile_size.x), floor_div(m_camera.y, tile_size.y) };
+		const IVec2 last_tile = { floor_div(m_camera.x + view.width - 1, tile_size.x), floor_div(m_camera.y + view.height - 1, tile_size.y) };
+		const Rect needed_tiles = { first_tile.x, first_tile.y, last_tile.x - first_tile.x + 1, last_tile.y - first_tile.y + 1 };
+
+		/* Copy in newly exposed tiles and tiles of changed chunks */
+		const IVec2 num_chunks = tilemap.num_chunks();
+		for (int32_t y = needed_tiles.y; y < needed_tiles.y + needed_tiles.height; y++) {
+			for (int32_t x = needed_tiles.x; x < needed_tiles.x + needed_tiles.width; x++) {
+				bool is_stale = !m_tiles.contains(IVec2 { x, y });
+				if (!is_stale && 0 <= x && x < tilemap.size().x && 0 <= y && y < tilemap.size().y) {
+					const IVec2 chunk = { x / TileMap::CHUNK_SIZE, y / TileMap::CHUNK_SIZE };
+					is_stale = m_chunk_versions[chunk.x + (size_t)chunk.y * num_chunks.x] != tilemap.chunk_version(chunk.x, chunk.y);
+				}
+				if (is_stale) {
+					_copy_tile(tilemap, tileset, IVec2 { x, y });
+				}
+			}
+		}
+		m_tiles = needed_tiles;
+
+		/* Remember chunk versions of the copied tiles */
+		// Tiles of changed chunks outside of the buffer get copied once exposed anyway
+		for (int32_t chunk_y = 0; chunk_y < num_chunks.y; chunk_y++) {
+			for (int32_t chunk_x = 0; chunk_x < num_chunks.x; chunk_x++) {
+				m_chunk_versions[chunk_x + (size_t)chunk_y * num_chunks.x] = tilemap.chunk_version(chunk_x, chunk_y);
+			}
+		}
+
+		/* Find cheapest way to blend the tiles under view */
+		// Slots outside of the view still hold whatever was copied last, so they're left out
+		m_alpha_mode = AlphaMode::Opaque;
+		for (int32_t y = needed_tiles.y; y < needed_tiles.y + needed_tiles.height; y++) {
+			for (int32_t x = needed_tiles.x; x < needed_tiles.x + needed_tiles.width; x++) {
+				const IVec2 slot = { wrap(x, m_num_tiles.x), wrap(y, m_num_tiles.y) };
+				m_alpha_mode = engine::max(m_alpha_mode, m_tile_alpha_modes[slot.x + (size_t)slot.y * m_num_tiles.x]);
+			}
+		}
+	}
+
+	void ScrollBuffer::draw(Bitmap* bitmap, Rect clip) const {
+		const Rect dst_rect = Rect::intersection(m_view, clip);
+		if (!dst_rect.has_area()) {
+			return;
+		}
+
+		/* Copy each row in at most two spans, split where the buffer wraps around */
+		const int32_t buffer_width = m_num_tiles.x * m_tile_size.x;
+		const int32_t buffer_height = m_num_tiles.y * m_tile_size.y;
+		const int32_t src_x = wrap(m_camera.x + dst_rect.x - m_view.x, buffer_width);
+		const int32_t first_length = engine::min(dst_rect.width, buffer_width - src_x);
+		for (int32_t y = dst_rect.y; y < dst_rect.y + dst_rect.height; y++) {
+			const int32_t src_y = wrap(m_camera.y + y - m_view.y, buffer_height);
+			const Pixel* src_row = &m_pixels[(size_t)src_y * buffer_width];
+			bitmap->blend_span(dst_rect.x, y, first_length, src_row + src_x, m_alpha_mode, false);
+			if (first_length < dst_rect.width) {
+				bitmap->blend_span(dst_rect.x + first_length, y, dst_rect.width - first_length, src_row, m_alpha_mode, false);
+			}
+		}
+	}
+
+	Rect ScrollBuffer::view() const {
+		return m_view;
+	}
+
+	int64_t ScrollBuffer::num_copied_tiles() const {
+		return m_num_copied_tiles;
+	}
+
+	AlphaMode ScrollBuffer::alpha_mode() const {
+		return m_alpha_mode;
+	}
+
+	void ScrollBuffer::_reset(const TileMap& tilemap, Rect view) {
+		// A view that isn't tile aligned can straddle one more tile than it fits
+		m_tileset = tilemap.tileset();
+		m_tile_size = tilemap.tile_size();
+		m_num_tiles = {
+			(view.width + m_tile_size.x - 1) / m_tile_size.x + 1,
+			(view.height + m_tile_size.y - 1) / m_tile_size.y + 1,
+		};
+		m_pixels.assign((size_t)m_num_tiles.x * m_tile_size.x * m_num_tiles.y * m_tile_size.y, Pixel {});
+		m_tile_alpha_modes.assign((size_t)m_num_tiles.x * m_num_tiles.y, AlphaMode::Binary);
+		m_alpha_mode = AlphaMode::Binary;
+		m_chunk_versions.assign((size_t)tilemap.num_chunks().x * tilemap.num_chunks().y, 0);
+		m_tiles = {};
+	}
+
+	void ScrollBuffer::_copy_tile(const TileMap& tilemap, const Image& tileset, IVec2 tile) {
+		m_num_copied_tiles++;
+		const IVec2 slot = { wrap(tile.x, m_num_tiles.x), wrap(tile.y, m_num_tiles.y) };
+		const int32_t buffer_width = m_num_tiles.x * m_tile_size.x;
+		Pixel* dst = &m_pixels[slot.x * m_tile_size.x + (size_t)slot.y * m_tile_size.y * buffer_width];
+
+		/* Find tile in tileset */
+		const uint16_t index = tilemap.tile(tile.x, tile.y);
+		const int32_t tileset_columns = engine::max(tileset.width / m_tile_size.x, 1);
+		const IVec2 src = { (index % tileset_columns) * m_tile_size.x, (index / tileset_columns) * m_tile_size.y };
+		const bool is_empty = index == TileMap::EMPTY_TILE || src.x + m_tile_size.x > tileset.width || src.y + m_tile_size.y > tileset.height;
+		m_tile_alpha_modes[slot.x + (size_t)slot.y * m_num_tiles.x] = is_empty ? AlphaMode::Binary : tileset.alpha_mode;
+
+		/* Copy tile rows, leaving empty tiles transparent */
+		for (int32_t y = 0; y < m_tile_size.y; y++) {
+			Pixel* dst_row = dst + (size_t)y * buffer_width;
+			if (is_empty) {
+				std::fill(dst_row, dst_row + m_tile_size.x, Pixel {});
+			}
+			else {
+				const Pixel* src_row = &tileset.pixels[src.x + (size_t)(src.y + y) * tileset.width];
+				std::copy(src_row, src_row + m_tile_size.x, dst_row);
+			}
+		}
+	}
+
+} // namespace engine
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <engine/graphics/image_id.h>
+#include <engine/graphics/pixel.h>
+#include <engine/graphics/rect.h>
+#include <engine/math/ivec2.h>
+
+#include <stdint.h>
+#include <vector>
+
+namespace engine {
+
+	class Bitmap;
+	class TileMap;
+	struct Image;
+
+	// Wrap-around buffer of the tile map pixels under a view, like NES nametables
+	//
+	// The buffer is one tile larger than the view in each direction, and world
+	// tile (x,y) is kept at buffer tile (x mod columns, y mod rows). Moving the
+	// view only copies in the tiles it newly exposes, plus the tiles of chunks
+	// that changed, and drawing it takes at most two row copies per scanline.
+	class ScrollBuffer {
+	public:
+		// Brings buffer up to date for tile map drawn with its top left at `pos`, seen through `view`
+		void update(const TileMap& tilemap, const Image& tileset, IVec2 pos, Rect view);
+		void draw(Bitmap* bitmap, Rect clip) const;
+
+		Rect view() const;
+		int64_t num_copied_tiles() const; // by the last update
+		AlphaMode alpha_mode() const; // of the tiles under the view
+
+	private:
+		void _reset(const TileMap& tilemap, Rect view);
+		void _copy_tile(const TileMap& tilemap, const Image& tileset, IVec2 tile);
+
+		ImageID m_tileset = {};
+		IVec2 m_tile_size = {};
+		IVec2 m_num_tiles = {}; // columns and rows of buffer
+		std::vector<Pixel> m_pixels; // premultiplied
+		std::vector<AlphaMode> m_tile_alpha_modes; // per buffer tile
+		AlphaMode m_alpha_mode = AlphaMode::Binary; // cheapest way to blend the tiles under the view
+		std::vector<uint32_t> m_chunk_versions; // of tile map when its tiles were copied
+
+		Rect m_view = {};
+		IVec2 m_camera = {}; // world position of top left of view
+		Rect m_tiles = {}; // world tiles in buffer, no area until first update
+		int64_t m_num_copied_tiles = 0;
+	};
+
+} // namespace engine
@@ -0,0 +1,145 @@
+#include <engine/graphics/text_layout.h>
+
+#include <engine/graphics/font.h>
+#include <engine/utility/string_utility.h>
+
+#include <algorithm>
+
+namespace engine {
+
+	TextLayout TextLayout::from_text(const Typeface& typeface, int32_t font_size, IVec2 rect_size, HorizontalAlignment h_alignment, const std::string& text) {
+		const int32_t ascent = typeface.ascent(font_size);
+		const int32_t space_width = typeface.glyph(font_size, ' ').advance_width;
+
+		TextLayout layout;
+		int32_t cursor_x = 0;
+		int32_t cursor_y = ascent;
+
+		/* Bounding rect defaults */
+		layout.size = rect_size;
+		if (layout.size.x == 0) {
+			layout.size.x = typeface.text_width(font_size, text);
+		}
+		if (layout.size.y == 0) {
+			layout.size.y = font_size + 1;
+		}
+
+		/* Lay out text row-by-row */
+		const std::vector<std::string> words = split_string_into_words(text);
+		auto line_start = words.begin();
+		while (line_start != words.end() && cursor_y < layout.size.y) {
+			/* Find how many words fit current row */
+			int line_width = 0;
+			auto line_end = line_start;
+			for (; line_end != words.end(); ++line_end) {
+				const std::string& word = *line_end;
+				const int word_width = typeface.text_width(font_size, word);
+				const int needed_width = (line_width > 0 ? line_width + space_width : line_width) + word_width;
+				if (needed_width > layout.size.x) {
+					break;
+				}
+				line_width = needed_width;
+			}
+
+			/* Compute word position based on alignment */
+			const int row_remainder = layout.size.x - line_width;
+			switch (h_alignment) {
+				case HorizontalAlignment::Left: cursor_x = 0; break;
+				case HorizontalAlignment::Center: cursor_x = row_remainder / 2; break;
+				case HorizontalAlignment::Right: cursor_x = row_remainder; break;
+			}
+
+			/* Place all words in current row */
+			Row row = { .top = INT32_MAX, .bottom = INT32_MIN, .first_glyph = (uint32_t)layout.glyphs.size() };
+			for (auto it = line_start; it != line_end; ++it) {
+				const std::string& word = *it;
+				for (char character : word) {
+					const Glyph& glyph = typeface.glyph(font_size, character);
+					if (glyph.width > 0 && glyph.height > 0) {
+						const IVec2 pos = { cursor_x + glyph.left_side_bearing, cursor_y + glyph.y_offset };
+						layout.glyphs.push_back(PositionedGlyph { .glyph = &glyph, .pos = pos });
+						row.top = std::min(row.top, pos.y);
+						row.bottom = std::max(row.bottom, pos.y + glyph.height);
+					}
+
+					/* Go to next column */
+					cursor_x += glyph.advance_width;
+				}
+
+				/* Add space between words */
+				cursor_x += space_width;
+			}
+
+			row.end_glyph = (uint32_t)layout.glyphs.size();
+			if (row.end_glyph > row.first_glyph) {
+				layout.rows.push_back(row);
+			}
+
+			/* Advance to next row */
+			cursor_y += ascent;
+			line_start = line_end;
+		}
+
+		return layout;
+	}
+
+	TextLayoutCache::TextLayoutCache(size_t capacity)
+		: m_capacity(capacity) {
+	}
+
+	std::shared_ptr<const TextLayout> TextLayoutCache::layout(const Typeface& typeface, FontID font_id, int32_t font_size, IVec2 rect_size, HorizontalAlignment h_alignment, std::string_view text) {
+		const Key key = {
+			.font_id = font_id,
+			.font_size = font_size,
+			.rect_size = rect_size,
+			.h_alignment = h_alignment,
+			.text_hash = std::hash<std::string_view>()(text),
+		};
+
+		/* Look up cached layout */
+		if (auto it = m_lookup.find(key); it != m_lookup.end()) {
+			auto entry = it->second;
+			if (entry->text == text) {
+				m_stats.hits++;
+				m_entries.splice(m_entries.begin(), m_entries, entry);
+				return entry->layout;
+			}
+			m_entries.erase(entry);
+			m_lookup.erase(it);
+		}
+
+		/* Lay out text and evict least recently used */
+		m_stats.misses++;
+		std::string text_string = std::string(text);
+		auto layout = std::make_shared<const TextLayout>(TextLayout::from_text(typeface, font_size, rect_size, h_alignment, text_string));
+		m_entries.push_front(Entry { key, std::move(text_string), layout });
+		m_lookup[key] = m_entries.begin();
+		while (m_entries.size() > m_capacity) {
+			m_lookup.erase(m_entries.back().key);
+			m_entries.pop_back();
+		}
+		return layout;
+	}
+
+	void TextLayoutCache::clear() {
+		m_entries.clear();
+		m_lookup.clear();
+	}
+
+	size_t TextLayoutCache::size() const {
+		return m_entries.size();
+	}
+
+	TextLayoutCache::Stats TextLayoutCache::stats() const {
+		return m_stats;
+	}
+
+	size_t TextLayoutCache::KeyHash::operator()(const Key& key) const noexcept {
+		size_t hash = key.text_hash;
+		for (size_t value : { std::hash<int>()(key.font_id.value), std::hash<int32_t>()(key.font_size), std::hash<IVec2>()(key.rect_size), std::hash<int>()((int)key.h_alignment) }) {
+			hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2); // boost::hash_combine
+		}
+		return hash;
+	}
+
+} // namespace engine
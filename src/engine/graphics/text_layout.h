@@ -0,0 +1,91 @@
+#pragma once
+
+#include <engine/graphics/font_id.h>
+#include <engine/math/ivec2.h>
+
+#include <list>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+namespace engine {
+
+	struct Glyph;
+	class Typeface;
+
+	enum class HorizontalAlignment {
+		Left,
+		Center,
+		Right,
+	};
+
+	// Glyphs of a text laid out inside of a rect, ready to be blitted
+	//
+	// Glyph pointers point into the typeface, and stay valid as long as its fonts do.
+	struct TextLayout {
+		struct PositionedGlyph {
+			const Glyph* glyph;
+			IVec2 pos; // top left of glyph bitmap, relative to rect
+		};
+
+		// Glyphs of a row of text, so that rows outside of a clip rect can be skipped
+		struct Row {
+			int32_t top; // of the row's glyph bitmaps, relative to rect
+			int32_t bottom; // one past the lowest glyph bitmap pixel
+			uint32_t first_glyph; // into glyphs
+			uint32_t end_glyph;
+		};
+
+		IVec2 size; // rect size with defaults applied
+		std::vector<PositionedGlyph> glyphs;
+		std::vector<Row> rows;
+
+		static TextLayout from_text(const Typeface& typeface, int32_t font_size, IVec2 rect_size, HorizontalAlignment h_alignment, const std::string& text);
+	};
+
+	// Least recently used cache of text layouts
+	class TextLayoutCache {
+	public:
+		struct Stats {
+			int64_t hits;
+			int64_t misses;
+		};
+
+		static constexpr size_t DEFAULT_CAPACITY = 256;
+
+		TextLayoutCache() = default;
+		explicit TextLayoutCache(size_t capacity);
+
+		std::shared_ptr<const TextLayout> layout(const Typeface& typeface, FontID font_id, int32_t font_size, IVec2 rect_size, HorizontalAlignment h_alignment, std::string_view text);
+		void clear();
+
+		size_t size() const;
+		Stats stats() const;
+
+	private:
+		struct Key {
+			FontID font_id;
+			int32_t font_size;
+			IVec2 rect_size;
+			HorizontalAlignment h_alignment;
+			size_t text_hash;
+			bool operator==(const Key& rhs) const = default;
+		};
+		struct KeyHash {
+			size_t operator()(const Key& key) const noexcept;
+		};
+		struct Entry {
+			Key key;
+			std::string text; // guards against hash collisions
+			std::shared_ptr<const TextLayout> layout;
+		};
+
+		size_t m_capacity = DEFAULT_CAPACITY;
+		std::list<Entry> m_entries; // most recently used first
+		std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_lookup;
+		Stats m_stats = {};
+	};
+
+} // namespace engine
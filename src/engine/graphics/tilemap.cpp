@@ -0,0 +1,93 @@
+#include <engine/graphics/tilemap.h>
+
+#include <atomic>
+#include <chrono>
+
+namespace engine {
+
+	static uint64_t next_tilemap_identity() {
+		/* Start from the load time, so maps made after a hot reload don't reuse old identities */
+		static std::atomic<uint64_t> next_identity = (uint64_t)std::chrono::steady_clock::now().time_since_epoch().count();
+		return next_identity++;
+	}
+
+	TileMap::Identity::Identity()
+		: value(next_tilemap_identity()) {
+	}
+
+	TileMap::Identity::Identity(const Identity&)
+		: value(next_tilemap_identity()) {
+	}
+
+	TileMap::Identity& TileMap::Identity::operator=(const Identity&) {
+		value = next_tilemap_identity();
+		return *this;
+	}
+
+	TileMap TileMap::with_size(ImageID tileset, IVec2 tile_size, IVec2 size) {
+		TileMap tilemap;
+		tilemap.m_tileset = tileset;
+		tilemap.m_tile_size = tile_size;
+		tilemap.m_size = size;
+		tilemap.m_num_chunks = {
+			(size.x + CHUNK_SIZE - 1) / CHUNK_SIZE,
+			(size.y + CHUNK_SIZE - 1) / CHUNK_SIZE,
+		};
+		tilemap.m_tiles.resize((size_t)size.x * size.y, EMPTY_TILE);
+		tilemap.m_chunk_versions.resize((size_t)tilemap.m_num_chunks.x * tilemap.m_num_chunks.y, 0);
+		return tilemap;
+	}
+
+	void TileMap::set_tile(int32_t x, int32_t y, uint16_t tile) {
+		if (x < 0 || x >= m_size.x || y < 0 || y >= m_size.y) {
+			return;
+		}
+		uint16_t& current = m_tiles[x + (size_t)y * m_size.x];
+		if (current == tile) {
+			return;
+		}
+		current = tile;
+		m_chunk_versions[x / CHUNK_SIZE + (size_t)(y / CHUNK_SIZE) * m_num_chunks.x]++;
+		m_version++;
+	}
+
+	uint16_t TileMap::tile(int32_t x, int32_t y) const {
+		if (x < 0 || x >= m_size.x || y < 0 || y >= m_size.y) {
+			return EMPTY_TILE;
+		}
+		return m_tiles[x + (size_t)y * m_size.x];
+	}
+
+	ImageID TileMap::tileset() const {
+		return m_tileset;
+	}
+
+	IVec2 TileMap::tile_size() const {
+		return m_tile_size;
+	}
+
+	IVec2 TileMap::size() const {
+		return m_size;
+	}
+
+	IVec2 TileMap::pixel_size() const {
+		return IVec2 { m_size.x * m_tile_size.x, m_size.y * m_tile_size.y };
+	}
+
+	IVec2 TileMap::num_chunks() const {
+		return m_num_chunks;
+	}
+
+	uint32_t TileMap::chunk_version(int32_t chunk_x, int32_t chunk_y) const {
+		return m_chunk_versions[chunk_x + (size_t)chunk_y * m_num_chunks.x];
+	}
+
+	uint32_t TileMap::version() const {
+		return m_version;
+	}
+
+	uint64_t TileMap::identity() const {
+		return m_identity.value;
+	}
+
+} // namespace engine
@@ -0,0 +1,57 @@
+#pragma once
+
+#include <engine/graphics/image_id.h>
+#include <engine/math/ivec2.h>
+
+#include <stdint.h>
+#include <vector>
+
+namespace engine {
+
+	// Grid of tiles drawn from a tileset image
+	//
+	// Tile index `i` is the i:th tile of the tileset, counting row by row. Tiles
+	// are grouped into square chunks, each with a version that is bumped when
+	// one of its tiles changes, so renderers can cache pre-rendered chunks.
+	class TileMap {
+	public:
+		static constexpr uint16_t EMPTY_TILE = UINT16_MAX;
+		static constexpr int32_t CHUNK_SIZE = 16; // in tiles
+
+		TileMap() = default;
+		static TileMap with_size(ImageID tileset, IVec2 tile_size, IVec2 size);
+
+		void set_tile(int32_t x, int32_t y, uint16_t tile);
+		uint16_t tile(int32_t x, int32_t y) const;
+
+		ImageID tileset() const;
+		IVec2 tile_size() const; // in pixels
+		IVec2 size() const; // in tiles
+		IVec2 pixel_size() const;
+		IVec2 num_chunks() const;
+		uint32_t chunk_version(int32_t chunk_x, int32_t chunk_y) const;
+		uint32_t version() const; // bumped when any tile changes
+		uint64_t identity() const; // unique to this map, changed when copied or assigned over
+
+	private:
+		// Taken from a process-wide counter whenever a map is made, copied or
+		// assigned, so a map replaced in place isn't mistaken for the old one
+		// just because their chunk versions happen to match
+		struct Identity {
+			uint64_t value;
+			Identity();
+			Identity(const Identity&);
+			Identity& operator=(const Identity&);
+		};
+
+		ImageID m_tileset = {};
+		IVec2 m_tile_size = {};
+		IVec2 m_size = {};
+		IVec2 m_num_chunks = {};
+		std::vector<uint16_t> m_tiles; // row by row
+		std::vector<uint32_t> m_chunk_versions; // row by row
+		uint32_t m_version = 0;
+		Identity m_identity;
+	};
+
+} // namespace engine
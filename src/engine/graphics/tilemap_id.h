@@ -0,0 +1,12 @@
+#pragma once
+
+namespace engine {
+
+	struct TileMapID {
+		int value;
+		bool operator==(const TileMapID& rhs) const = default;
+	};
+
+	constexpr TileMapID INVALID_TILEMAP_ID = TileMapID(0);
+
+} // namespace engine
@@ -0,0 +1,109 @@
+#include <engine/graphics/transformed_image_cache.h>
+
+#include <utility>
+
+namespace engine {
+
+	static Image transform_image(const Image& image, Rect clip, bool flip_h, bool flip_v, Color tint) {
+		const bool is_tinted = tint.a > 0 && tint != Color::white();
+		std::vector<Pixel> pixels;
+		pixels.reserve((size_t)clip.width * clip.height);
+		for (int32_t y = 0; y < clip.height; y++) {
+			const int32_t src_y = clip.y + (flip_v ? clip.height - 1 - y : y);
+			const Pixel* src_row = &image.pixels[(size_t)src_y * image.width + clip.x];
+			for (int32_t x = 0; x < clip.width; x++) {
+				const Pixel pixel = src_row[flip_h ? clip.width - 1 - x : x];
+				pixels.push_back(is_tinted ? pixel.tinted(tint) : pixel);
+			}
+		}
+		return Image::from_pixels(clip.width, clip.height, std::move(pixels));
+	}
+
+	static size_t image_bytes(const Image& image) {
+		return image.pixels.size() * sizeof(Pixel)
+			+ image.runs.size() * sizeof(ImageRun)
+			+ image.row_runs.size() * sizeof(uint32_t);
+	}
+
+	TransformedImageCache::TransformedImageCache(size_t budget)
+		: m_budget(budget) {
+	}
+
+	std::shared_ptr<const Image> TransformedImageCache::image(const Image& image, ImageID image_id, Rect clip, bool flip_h, bool flip_v, Color tint) {
+		const Key key = {
+			.image_id = image_id,
+			.clip = clip,
+			.flip_h = flip_h,
+			.flip_v = flip_v,
+			.tint = tint,
+		};
+
+		/* Look up cached image */
+		if (auto it = m_lookup.find(key); it != m_lookup.end()) {
+			m_stats.hits++;
+			m_entries.splice(m_entries.begin(), m_entries, it->second);
+			return it->second->image;
+		}
+
+		/* Transform image and evict least recently used */
+		m_stats.misses++;
+		auto transformed = std::make_shared<const Image>(transform_image(image, clip, flip_h, flip_v, tint));
+		const size_t bytes = image_bytes(*transformed);
+		m_entries.push_front(Entry { key, bytes, transformed });
+		m_lookup[key] = m_entries.begin();
+		m_stats.bytes += bytes;
+		_evict_to_budget();
+		return transformed;
+	}
+
+	void TransformedImageCache::set_budget(size_t budget) {
+		m_budget = budget;
+		_evict_to_budget();
+	}
+
+	void TransformedImageCache::clear() {
+		m_entries.clear();
+		m_lookup.clear();
+		m_stats.bytes = 0;
+	}
+
+	size_t TransformedImageCache::size() const {
+		return m_entries.size();
+	}
+
+	size_t TransformedImageCache::budget() const {
+		return m_budget;
+	}
+
+	TransformedImageCache::Stats TransformedImageCache::stats() const {
+		return m_stats;
+	}
+
+	void TransformedImageCache::_evict_to_budget() {
+		// Returned images are shared, so evicting one that was just handed out is safe
+		while (m_stats.bytes > m_budget && !m_entries.empty()) {
+			m_stats.bytes -= m_entries.back().bytes;
+			m_stats.evictions++;
+			m_lookup.erase(m_entries.back().key);
+			m_entries.pop_back();
+		}
+	}
+
+	bool TransformedImageCache::Key::operator==(const Key& rhs) const {
+		return image_id == rhs.image_id
+			&& clip.x == rhs.clip.x && clip.y == rhs.clip.y && clip.width == rhs.clip.width && clip.height == rhs.clip.height
+			&& flip_h == rhs.flip_h && flip_v == rhs.flip_v
+			&& tint == rhs.tint;
+	}
+
+	size_t TransformedImageCache::KeyHash::operator()(const Key& key) const noexcept {
+		const uint32_t tint = ((uint32_t)key.tint.r << 24) | ((uint32_t)key.tint.g << 16) | ((uint32_t)key.tint.b << 8) | key.tint.a;
+		const int flips = (key.flip_h ? 1 : 0) | (key.flip_v ? 2 : 0);
+		size_t hash = std::hash<int>()(key.image_id.value);
+		for (size_t value : { std::hash<int32_t>()(key.clip.x), std::hash<int32_t>()(key.clip.y), std::hash<int32_t>()(key.clip.width), std::hash<int32_t>()(key.clip.height), std::hash<uint32_t>()(tint), std::hash<int>()(flips) }) {
+			hash ^= value + 0x9e3779b9 + (hash << 6) + (hash >> 2); // boost::hash_combine
+		}
+		return hash;
+	}
+
+} // namespace engine
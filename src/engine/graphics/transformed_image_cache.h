@@ -0,0 +1,67 @@
+#pragma once
+
+#include <engine/graphics/color.h>
+#include <engine/graphics/image.h>
+#include <engine/graphics/image_id.h>
+#include <engine/graphics/rect.h>
+
+#include <list>
+#include <memory>
+#include <unordered_map>
+
+namespace engine {
+
+	// Least recently used cache of clipped, flipped and tinted copies of images
+	//
+	// Drawing a cached copy skips per pixel flipping and tinting, which pays
+	// off for sprites that are drawn with the same transform every frame.
+	// Copies are evicted once their pixels no longer fit the memory budget.
+	class TransformedImageCache {
+	public:
+		struct Stats {
+			int64_t hits;
+			int64_t misses;
+			int64_t evictions;
+			size_t bytes; // memory used by cached images
+		};
+
+		static constexpr size_t DEFAULT_BUDGET = 4 * 1024 * 1024;
+
+		TransformedImageCache() = default;
+		explicit TransformedImageCache(size_t budget);
+
+		std::shared_ptr<const Image> image(const Image& image, ImageID image_id, Rect clip, bool flip_h, bool flip_v, Color tint);
+		void set_budget(size_t budget);
+		void clear();
+
+		size_t size() const;
+		size_t budget() const;
+		Stats stats() const;
+
+	private:
+		struct Key {
+			ImageID image_id;
+			Rect clip;
+			bool flip_h;
+			bool flip_v;
+			Color tint;
+			bool operator==(const Key& rhs) const;
+		};
+		struct KeyHash {
+			size_t operator()(const Key& key) const noexcept;
+		};
+		struct Entry {
+			Key key;
+			size_t bytes;
+			std::shared_ptr<const Image> image;
+		};
+
+		void _evict_to_budget();
+
+		size_t m_budget = DEFAULT_BUDGET;
+		std::list<Entry> m_entries; // most recently used first
+		std::unordered_map<Key, std::list<Entry>::iterator, KeyHash> m_lookup;
+		Stats m_stats = {};
+	};
+
+} // namespace engine
@@ -125,7 +125,16 @@ namespace engine {
 	void Window::render(const Bitmap& bitmap) {
 		CPUProfilingScope_Render();
 		HDC device_context = GetDC(m_handle);
-		_render(bitmap, device_context);
+		_render(bitmap, device_context, Rect { 0, 0, bitmap.width(), bitmap.height() });
+		ReleaseDC(m_handle, device_context);
+	}
+
+	void Window::render(const Bitmap& bitmap, const std::vector<Rect>& dirty_rects) {
+		CPUProfilingScope_Render();
+		HDC device_context = GetDC(m_handle);
+		for (Rect rect : dirty_rects) {
+			_render(bitmap, device_context, rect);
+		}
 		ReleaseDC(m_handle, device_context);
 	}
 
@@ -133,21 +142,27 @@ namespace engine {
 		CPUProfilingScope_Render();
 		PAINTSTRUCT paint;
 		HDC device_context = BeginPaint(m_handle, &paint);
-		_render(bitmap, device_context);
+		_render(bitmap, device_context, Rect { 0, 0, bitmap.width(), bitmap.height() });
 		EndPaint(m_handle, &paint);
 	}
 
-	void Window::_render(const Bitmap& bitmap, HDC device_context) {
+	void Window::_render(const Bitmap& bitmap, HDC device_context, Rect rect) {
 		// Can't render empty bitmap
 		if (bitmap.empty()) {
 			return;
 		}
+		rect = Rect::intersection(rect, Rect { 0, 0, bitmap.width(), bitmap.height() });
+		if (!rect.has_area()) {
+			return;
+		}
 
+		// NOTE: the DIB only covers the rows of `rect`, since StretchDIBits
+		// measures the source y coordinate from the bottom for top-down DIBs.
 		BITMAPINFO bitmap_info = BITMAPINFO {
 			.bmiHeader = BITMAPINFOHEADER {
 				.biSize = sizeof(BITMAPINFOHEADER),
 				.biWidth = bitmap.width(),
-				.biHeight = -bitmap.height(),
+				.biHeight = -rect.height,
 				.biPlanes = 1,
 				.biBitCount = 32,
 				.biCompression = BI_RGB,
@@ -159,24 +174,25 @@ namespace engine {
 			std::max(m_window_size.y / bitmap.height(), 1)
 		);
 		IVec2 upscaled_bitmap_size = scale * IVec2 { bitmap.width(), bitmap.height() };
+		IVec2 upscaled_bitmap_pos = (m_window_size - upscaled_bitmap_size) / 2;
 
 		StretchDIBits(
 			device_context,
 
 			// destination rect (window)
-			(m_window_size.x - upscaled_bitmap_size.x) / 2,
-			(m_window_size.y - upscaled_bitmap_size.y) / 2,
-			upscaled_bitmap_size.x,
-			upscaled_bitmap_size.y,
+			upscaled_bitmap_pos.x + scale * rect.x,
+			upscaled_bitmap_pos.y + scale * rect.y,
+			scale * rect.width,
+			scale * rect.height,
 
 			// source rect (bitmap)
+			rect.x,
 			0,
-			0,
-			bitmap.width(),
-			bitmap.height(),
+			rect.width,
+			rect.height,
 
 			// bitmap data
-			bitmap.data(),
+			bitmap.data() + rect.y * bitmap.width(),
 			&bitmap_info,
 			DIB_RGB_COLORS,
 			SRCCOPY
@@ -1,12 +1,14 @@
 #pragma once
 
 #include <engine/graphics/bitmap.h>
+#include <engine/graphics/rect.h>
 #include <engine/math/ivec2.h>
 
 #include <windows.h>
 
 #include <optional>
 #include <string>
+#include <vector>
 
 namespace engine {
 
@@ -25,10 +27,11 @@ namespace engine {
 		void set_title(const std::string& title);
 
 		void render(const Bitmap& bitmap);
+		void render(const Bitmap& bitmap, const std::vector<Rect>& dirty_rects); // only uploads the dirty rects
 		void render_wm_paint(const Bitmap& bitmap);
 
 	private:
-		void _render(const Bitmap& bitmap, HDC device_context);
+		void _render(const Bitmap& bitmap, HDC device_context, Rect rect);
 
 		HWND m_handle;
 		WINDOWPLACEMENT m_placement = { sizeof(WINDOWPLACEMENT) };
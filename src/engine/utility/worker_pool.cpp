@@ -0,0 +1,76 @@
+#include <engine/utility/worker_pool.h>
+
+namespace engine {
+
+	WorkerPool::~WorkerPool() {
+		stop();
+	}
+
+	void WorkerPool::run(int32_t num_threads, const std::function<void()>& job) {
+		const int32_t num_job_workers = num_threads - 1;
+		if (num_job_workers <= 0) {
+			job();
+			return;
+		}
+
+		/* Start missing workers and hand them the job */
+		{
+			std::lock_guard lock(m_mutex);
+			for (int32_t i = (int32_t)m_workers.size(); i < num_job_workers; i++) {
+				m_workers.emplace_back(&WorkerPool::_work, this, i, m_job_index);
+			}
+			m_job = &job;
+			m_job_index++;
+			m_num_job_workers = num_job_workers;
+			m_num_running_workers = num_job_workers;
+		}
+		m_job_started.notify_all();
+
+		/* Work on job until every worker is done with it */
+		job();
+		std::unique_lock lock(m_mutex);
+		m_job_finished.wait(lock, [&] { return m_num_running_workers == 0; });
+		m_job = nullptr;
+	}
+
+	void WorkerPool::stop() {
+		{
+			std::lock_guard lock(m_mutex);
+			m_is_stopping = true;
+		}
+		m_job_started.notify_all();
+		for (std::thread& worker : m_workers) {
+			worker.join();
+		}
+		m_workers.clear();
+		m_is_stopping = false;
+	}
+
+	int32_t WorkerPool::num_workers() const {
+		return (int32_t)m_workers.size();
+	}
+
+	void WorkerPool::_work(int32_t worker_index, int64_t first_job) {
+		int64_t last_job = first_job;
+		std::unique_lock lock(m_mutex);
+		while (true) {
+			m_job_started.wait(lock, [&] { return m_is_stopping || m_job_index != last_job; });
+			if (m_is_stopping) {
+				return;
+			}
+			last_job = m_job_index;
+			if (worker_index >= m_num_job_workers) {
+				continue;
+			}
+
+			const std::function<void()>* job = m_job;
+			lock.unlock();
+			(*job)();
+			lock.lock();
+			if (--m_num_running_workers == 0) {
+				m_job_finished.notify_one();
+			}
+		}
+	}
+
+} // namespace engine
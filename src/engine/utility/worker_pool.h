@@ -0,0 +1,46 @@
+#pragma once
+
+#include <condition_variable>
+#include <cstdint>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace engine {
+
+	// Threads that are kept alive between jobs, instead of being started and
+	// joined for each one
+	//
+	// The calling thread works on every job too, and workers are only started
+	// once a job needs them. stop() joins them, e.g. before unloading the
+	// library their code lives in, and the next job starts them again.
+	class WorkerPool {
+	public:
+		WorkerPool() = default;
+		WorkerPool(const WorkerPool&) = delete;
+		WorkerPool& operator=(const WorkerPool&) = delete;
+		~WorkerPool();
+
+		// Calls `job` on `num_threads` threads, counting the calling one, and
+		// returns once every call has returned
+		void run(int32_t num_threads, const std::function<void()>& job);
+		void stop();
+
+		int32_t num_workers() const; // started and not yet stopped
+
+	private:
+		void _work(int32_t worker_index, int64_t first_job);
+
+		std::vector<std::thread> m_workers;
+		std::mutex m_mutex;
+		std::condition_variable m_job_started;
+		std::condition_variable m_job_finished;
+		const std::function<void()>* m_job = nullptr;
+		int64_t m_job_index = 0; // bumped for every job, so workers notice new ones
+		int32_t m_num_job_workers = 0; // workers with an index below this run the current job
+		int32_t m_num_running_workers = 0;
+		bool m_is_stopping = false;
+	};
+
+} // namespace engine
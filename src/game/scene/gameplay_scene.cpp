@@ -8,6 +8,7 @@
 #include <engine/file/resource_manager.h>
 #include <engine/graphics/renderer.h>
 #include <engine/input/input.h>
+#include <engine/math/math.h>
 
 #include <windows.h>
 
@@ -15,6 +16,12 @@ namespace game {
 
 	using namespace std::chrono_literals;
 
+	// World is drawn below the UI, which stays on layer 0
+	enum class DrawLayer : int16_t {
+		Ground = -2,
+		Characters = -1, // sorted by y position of their feet
+	};
+
 	static std::unordered_map<Direction, engine::AnimationID> setup_walk_animations(engine::AnimationLibrary<SpriteAnimation>* animation_library) {
 		const engine::Time frame_duration = 200ms;
 		const int player_size = 16;
@@ -168,6 +175,7 @@ namespace game {
 	}
 
 	void GameplayScene::draw(const GameData& game, engine::Renderer* renderer) const {
+		renderer->set_draw_layer((int16_t)DrawLayer::Ground);
 		renderer->clear_screen(engine::Color { 252, 216, 168, 255 });
 
 		constexpr int player_size = 16;
@@ -184,7 +192,12 @@ namespace game {
 		};
 
 		SpriteAnimation player_animation = m_animation_player.value();
+		// Clamped, since a player far off-screen would wrap around to the other end of the depth range
+		const int16_t player_depth = (int16_t)engine::clamp(player_rect.y + player_rect.height, (int)INT16_MIN, (int)INT16_MAX);
+		renderer->set_draw_layer((int16_t)DrawLayer::Characters, player_depth);
 		renderer->draw_image(m_sprite_sheet_id, world_player_pos, { .clip = player_animation.clip, .flip_h = player_animation.flip_h });
+
+		renderer->set_draw_layer(0);
 	}
 
 } // namespace game
@@ -0,0 +1,186 @@
+#include <gtest/gtest.h>
+
+#include <engine/graphics/bitmap.h>
+
+#include <vector>
+
+using namespace engine;
+
+constexpr Pixel BACKGROUND = { .b = 10, .g = 100, .r = 200, .a = 0 };
+constexpr Pixel FOREGROUND = { .b = 250, .g = 30, .r = 0, .a = 0 };
+
+TEST(BitmapTests, FillSpan_ClipsToBitmap) {
+	Bitmap bitmap = Bitmap::with_size(8, 2);
+	bitmap.clear(BACKGROUND);
+
+	bitmap.fill_span(-3, 1, 6, FOREGROUND);
+
+	for (int32_t x = 0; x < 8; x++) {
+		EXPECT_EQ(bitmap.get(x, 0), BACKGROUND);
+		EXPECT_EQ(bitmap.get(x, 1), x < 3 ? FOREGROUND : BACKGROUND);
+	}
+}
+
+TEST(BitmapTests, CopySpan_ClipsToBitmap) {
+	Bitmap bitmap = Bitmap::with_size(4, 1);
+	std::vector<Pixel> pixels = { FOREGROUND, BACKGROUND, FOREGROUND, BACKGROUND, FOREGROUND, BACKGROUND };
+
+	bitmap.copy_span(-2, 0, 6, pixels.data());
+
+	for (int32_t x = 0; x < 4; x++) {
+		EXPECT_EQ(bitmap.get(x, 0), pixels[x + 2]);
+	}
+}
+
+TEST(BitmapTests, BlendSpan_ConstantAlpha_MatchesPut) {
+	// long enough to go through both vectorized and scalar code paths
+	constexpr int32_t length = 29;
+	for (int alpha = 0; alpha <= 255; alpha++) {
+		Bitmap span_bitmap = Bitmap::with_size(length, 1);
+		Bitmap put_bitmap = Bitmap::with_size(length, 1);
+		span_bitmap.clear(BACKGROUND);
+		put_bitmap.clear(BACKGROUND);
+
+		span_bitmap.blend_span(0, 0, length, FOREGROUND, (uint8_t)alpha);
+		for (int32_t x = 0; x < length; x++) {
+			put_bitmap.put(x, 0, FOREGROUND, alpha / 255.0f);
+		}
+
+		for (int32_t x = 0; x < length; x++) {
+			Pixel span_pixel = span_bitmap.get(x, 0);
+			Pixel put_pixel = put_bitmap.get(x, 0);
+			EXPECT_EQ(span_pixel.r, put_pixel.r) << "alpha = " << alpha;
+			EXPECT_EQ(span_pixel.g, put_pixel.g) << "alpha = " << alpha;
+			EXPECT_EQ(span_pixel.b, put_pixel.b) << "alpha = " << alpha;
+		}
+	}
+}
+
+TEST(BitmapTests, BlendSpan_LeavesPaddingByte) {
+	constexpr int32_t length = 29;
+	constexpr Pixel padded_background = { .b = 10, .g = 100, .r = 200, .a = 77 };
+	std::vector<uint8_t> alphas(length);
+	for (int32_t x = 0; x < length; x++) {
+		alphas[x] = (uint8_t)(x * 9);
+	}
+	Bitmap bitmap = Bitmap::with_size(length, 3);
+	bitmap.clear(padded_background);
+
+	bitmap.blend_span(0, 0, length, FOREGROUND, (uint8_t)100);
+	bitmap.blend_span(0, 1, length, FOREGROUND, alphas.data());
+	for (int32_t x = 0; x < length; x++) {
+		bitmap.put(x, 2, FOREGROUND, 100 / 255.0f);
+	}
+
+	for (int32_t y = 0; y < 3; y++) {
+		for (int32_t x = 0; x < length; x++) {
+			EXPECT_EQ(bitmap.get(x, y).a, padded_background.a) << x << ", " << y;
+		}
+	}
+}
+
+TEST(BitmapTests, PutSpan_MatchesPut) {
+	constexpr int32_t length = 13;
+	for (int alpha = 0; alpha <= 255; alpha += 5) {
+		Bitmap span_bitmap = Bitmap::with_size(length, 1);
+		Bitmap put_bitmap = Bitmap::with_size(length, 1);
+		span_bitmap.clear(BACKGROUND);
+		put_bitmap.clear(BACKGROUND);
+
+		span_bitmap.put_span(-2, 0, length, FOREGROUND, alpha / 255.0f);
+		for (int32_t x = -2; x < length - 2; x++) {
+			put_bitmap.put(x, 0, FOREGROUND, alpha / 255.0f);
+		}
+
+		EXPECT_EQ(span_bitmap, put_bitmap) << "alpha = " << alpha;
+	}
+}
+
+TEST(BitmapTests, BlendSpan_PerPixelAlpha) {
+	constexpr int32_t length = 13;
+	Bitmap bitmap = Bitmap::with_size(length, 1);
+	bitmap.clear(BACKGROUND);
+	std::vector<uint8_t> alphas = { 0, 255, 0, 255, 0, 0, 0, 0, 255, 255, 255, 255, 0 };
+
+	bitmap.blend_span(0, 0, length, FOREGROUND, alphas.data());
+
+	for (int32_t x = 0; x < length; x++) {
+		EXPECT_EQ(bitmap.get(x, 0), alphas[x] ? FOREGROUND : BACKGROUND) << "x = " << x;
+	}
+}
+
+TEST(BitmapTests, BlendSpan_PerPixelColorAndAlpha) {
+	constexpr int32_t length = 13;
+	Bitmap bitmap = Bitmap::with_size(length, 1);
+	bitmap.clear(BACKGROUND);
+	std::vector<Pixel> pixels(length, FOREGROUND);
+	std::vector<uint8_t> alphas(length, 51); // 20%
+
+	bitmap.blend_span(0, 0, length, pixels.data(), alphas.data());
+
+	for (int32_t x = 0; x < length; x++) {
+		Pixel pixel = bitmap.get(x, 0);
+		EXPECT_EQ(pixel.b, 58); // 10 + (250 - 10) * 0.2
+		EXPECT_EQ(pixel.g, 86); // 100 + (30 - 100) * 0.2
+		EXPECT_EQ(pixel.r, 160); // 200 + (0 - 200) * 0.2
+	}
+}
+
+TEST(BitmapTests, BlendSpan_Colors_Reversed) {
+	constexpr int32_t length = 13;
+	Bitmap bitmap = Bitmap::with_size(length, 1);
+	bitmap.clear(BACKGROUND);
+	std::vector<Color> colors;
+	for (int32_t i = 0; i < length; i++) {
+		colors.push_back(Color { (uint8_t)i, 0, 0, (uint8_t)(i % 3 == 0 ? 0 : 255) });
+	}
+
+	// first color is clipped away
+	bitmap.blend_span(-1, 0, length, &colors.back(), true);
+
+	for (int32_t x = 0; x < length - 1; x++) {
+		Color color = colors[length - 2 - x];
+		Pixel expected = color.a == 0 ? BACKGROUND : Pixel::from_color(color);
+		EXPECT_EQ(bitmap.get(x, 0), expected) << "x = " << x;
+	}
+	EXPECT_EQ(bitmap.get(length - 1, 0), BACKGROUND);
+}
+
+TEST(BitmapTests, BlendSpan_Premultiplied_MatchesStraightAlpha) {
+	constexpr int32_t length = 29;
+	for (int alpha = 0; alpha <= 255; alpha += 5) {
+		Bitmap bitmap = Bitmap::with_size(length, 1);
+		bitmap.clear(BACKGROUND);
+		Color color = Color { FOREGROUND.r, FOREGROUND.g, FOREGROUND.b, (uint8_t)alpha };
+		std::vector<Pixel> pixels(length, Pixel::premultiplied(color));
+
+		bitmap.blend_span(0, 0, length, pixels.data(), AlphaMode::Blended, false);
+
+		for (int32_t x = 0; x < length; x++) {
+			Pixel pixel = bitmap.get(x, 0);
+			Pixel expected = BACKGROUND.lerp(FOREGROUND, alpha / 255.0f);
+			EXPECT_NEAR(pixel.r, expected.r, 1) << "alpha = " << alpha;
+			EXPECT_NEAR(pixel.g, expected.g, 1) << "alpha = " << alpha;
+			EXPECT_NEAR(pixel.b, expected.b, 1) << "alpha = " << alpha;
+		}
+	}
+}
+
+TEST(BitmapTests, BlendSpan_PremultipliedBinaryAlpha_Reversed) {
+	constexpr int32_t length = 13;
+	Bitmap bitmap = Bitmap::with_size(length, 1);
+	bitmap.clear(BACKGROUND);
+	std::vector<Pixel> pixels;
+	for (int32_t i = 0; i < length; i++) {
+		pixels.push_back(Pixel::premultiplied(Color { (uint8_t)i, 0, 0, (uint8_t)(i % 3 == 0 ? 0 : 255) }));
+	}
+
+	// first pixel is clipped away
+	bitmap.blend_span(-1, 0, length, &pixels.back(), AlphaMode::Binary, true);
+
+	for (int32_t x = 0; x < length - 1; x++) {
+		Pixel pixel = pixels[length - 2 - x];
+		EXPECT_EQ(bitmap.get(x, 0), pixel.a == 0 ? BACKGROUND : pixel) << "x = " << x;
+	}
+	EXPECT_EQ(bitmap.get(length - 1, 0), BACKGROUND);
+}
@@ -0,0 +1,99 @@
+#include <gtest/gtest.h>
+
+#include <engine/graphics/image.h>
+
+#include <vector>
+
+using namespace engine;
+
+constexpr Color CLEAR = { 0, 0, 0, 0 };
+constexpr Color HALF = { 255, 0, 0, 128 };
+constexpr Color SOLID = { 0, 255, 0, 255 };
+
+TEST(ImageTests, FromColors_FindsAlphaMode) {
+	std::vector<Color> opaque = { SOLID, SOLID };
+	std::vector<Color> binary = { SOLID, CLEAR };
+	std::vector<Color> blended = { SOLID, HALF };
+
+	EXPECT_EQ(Image::from_colors(2, 1, opaque.data()).alpha_mode, AlphaMode::Opaque);
+	EXPECT_EQ(Image::from_colors(2, 1, binary.data()).alpha_mode, AlphaMode::Binary);
+	EXPECT_EQ(Image::from_colors(2, 1, blended.data()).alpha_mode, AlphaMode::Blended);
+}
+
+TEST(ImageTests, FromColors_PremultipliesAlpha) {
+	Image image = Image::from_colors(1, 1, &HALF);
+
+	EXPECT_EQ(image.pixels[0], (Pixel { .b = 0, .g = 0, .r = 128, .a = 128 }));
+	EXPECT_EQ(image.get(0, 0), HALF);
+}
+
+TEST(ImageTests, FromColors_MostlyTransparent_BuildsRuns) {
+	// clang-format off
+	std::vector<Color> colors = {
+		CLEAR, SOLID, SOLID, HALF,  CLEAR, SOLID,
+		CLEAR, CLEAR, CLEAR, CLEAR, CLEAR, CLEAR,
+	};
+	// clang-format on
+	Image image = Image::from_colors(6, 2, colors.data());
+
+	ASSERT_TRUE(image.has_runs());
+	std::span<const ImageRun> first_row = image.runs_in_row(0);
+	ASSERT_EQ(first_row.size(), 3);
+	EXPECT_EQ(first_row[0].x, 1);
+	EXPECT_EQ(first_row[0].length, 2);
+	EXPECT_EQ(first_row[0].alpha_mode, AlphaMode::Opaque);
+	EXPECT_EQ(first_row[1].x, 3);
+	EXPECT_EQ(first_row[1].length, 1);
+	EXPECT_EQ(first_row[1].alpha_mode, AlphaMode::Blended);
+	EXPECT_EQ(first_row[2].x, 5);
+	EXPECT_EQ(first_row[2].length, 1);
+	EXPECT_TRUE(image.runs_in_row(1).empty());
+}
+
+TEST(ImageTests, FromColors_MostlyOpaque_HasNoRuns) {
+	std::vector<Color> colors = { SOLID, SOLID, SOLID, SOLID, SOLID, CLEAR };
+	Image image = Image::from_colors(6, 1, colors.data());
+
+	EXPECT_FALSE(image.has_runs());
+}
+
+TEST(ImageTests, FromColors_IsntIndexed) {
+	std::vector<Color> colors = { SOLID, CLEAR, HALF, SOLID };
+	Image image = Image::from_colors(2, 2, colors.data());
+
+	EXPECT_FALSE(image.is_indexed());
+}
+
+TEST(ImageTests, BuildIndices_FewColors_BuildsIndices) {
+	std::vector<Color> colors = { SOLID, CLEAR, HALF, SOLID };
+	Image image = Image::from_colors(2, 2, colors.data());
+
+	ASSERT_TRUE(image.build_indices());
+	ASSERT_TRUE(image.is_indexed());
+	EXPECT_EQ(image.palette.size, 3);
+	EXPECT_EQ(image.num_indexed_colors, 3);
+	EXPECT_EQ(image.indices, (std::vector<uint8_t> { 0, 1, 2, 0 }));
+	EXPECT_EQ(image.palette.get(image.get_index(0, 1)), HALF);
+}
+
+TEST(ImageTests, BuildIndices_TooManyColors_IsntIndexed) {
+	std::vector<Color> colors;
+	for (int i = 0; i < Palette::MAX_COLORS + 1; i++) {
+		colors.push_back(Color { (uint8_t)i, (uint8_t)(i >> 8), 0, 255 });
+	}
+	Image image = Image::from_colors((int)colors.size(), 1, colors.data());
+
+	EXPECT_FALSE(image.build_indices());
+	EXPECT_FALSE(image.is_indexed());
+}
+
+TEST(ImageTests, FromIndexed_ExpandsPalette) {
+	std::vector<Color> palette_colors = { CLEAR, SOLID, HALF };
+	Image image = Image::from_indexed(3, 1, { 2, 1, 0 }, Palette::from_colors(palette_colors));
+
+	EXPECT_EQ(image.get(0, 0), HALF);
+	EXPECT_EQ(image.get(1, 0), SOLID);
+	EXPECT_EQ(image.alpha_mode, AlphaMode::Blended);
+	EXPECT_EQ(image.palette.index_of(SOLID), 1);
+	EXPECT_EQ(image.num_indexed_colors, 3);
+}
@@ -0,0 +1,82 @@
+#include <gtest/gtest.h>
+
+#include <engine/container/linear_arena.h>
+
+#include <algorithm>
+
+using namespace engine;
+
+struct TestRecord {
+	int32_t a;
+	int64_t b;
+};
+
+TEST(LinearArenaTests, Push_ValuesAreAligned) {
+	LinearArena arena;
+
+	arena.push_string("abc");
+	uint32_t offset = arena.push(TestRecord { 1, 2 });
+
+	EXPECT_EQ(offset % LinearArena::ALIGNMENT, 0);
+	EXPECT_EQ(arena.get<TestRecord>(offset).a, 1);
+	EXPECT_EQ(arena.get<TestRecord>(offset).b, 2);
+}
+
+TEST(LinearArenaTests, Push_ValuesSurviveGrowing) {
+	LinearArena arena;
+
+	ArenaString string = arena.push_string("Hello, world!");
+	std::vector<uint32_t> offsets;
+	for (int32_t i = 0; i < 1000; i++) {
+		offsets.push_back(arena.push(TestRecord { i, 2 * i }));
+	}
+
+	EXPECT_EQ(arena.string(string), "Hello, world!");
+	for (int32_t i = 0; i < 1000; i++) {
+		EXPECT_EQ(arena.get<TestRecord>(offsets[i]).a, i);
+		EXPECT_EQ(arena.get<TestRecord>(offsets[i]).b, 2 * i);
+	}
+}
+
+TEST(LinearArenaTests, Clear_KeepsCapacity) {
+	LinearArena arena;
+	for (int32_t i = 0; i < 100; i++) {
+		arena.push(TestRecord { i, i });
+	}
+	size_t capacity = arena.capacity();
+
+	arena.clear();
+
+	EXPECT_EQ(arena.size(), 0);
+	EXPECT_EQ(arena.capacity(), capacity);
+}
+
+TEST(LinearArenaTests, PushString_Empty) {
+	LinearArena arena;
+
+	ArenaString string = arena.push_string("");
+
+	EXPECT_EQ(arena.string(string), "");
+}
+
+TEST(LinearArenaTests, PushSpan_ValuesSurviveGrowing) {
+	LinearArena arena;
+	const std::vector<uint16_t> values = { 3, 1, 4, 1, 5 };
+
+	arena.push_string("a");
+	ArenaSpan<uint16_t> span = arena.push_span(std::span<const uint16_t>(values));
+	for (int32_t i = 0; i < 1000; i++) {
+		arena.push(TestRecord { i, i });
+	}
+
+	EXPECT_EQ(span.offset % LinearArena::ALIGNMENT, 0);
+	EXPECT_TRUE(std::ranges::equal(arena.span(span), values));
+}
+
+TEST(LinearArenaTests, PushSpan_Empty) {
+	LinearArena arena;
+
+	ArenaSpan<uint16_t> span = arena.push_span(std::span<const uint16_t>());
+
+	EXPECT_TRUE(arena.span(span).empty());
+}
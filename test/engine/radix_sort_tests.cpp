@@ -0,0 +1,50 @@
+#include <gtest/gtest.h>
+
+#include <engine/container/radix_sort.h>
+
+#include <algorithm>
+#include <numeric>
+#include <random>
+
+using namespace engine;
+
+TEST(RadixSortTests, Sort_MatchesStableSort) {
+	std::mt19937_64 rng(1234);
+	std::vector<uint64_t> keys(1000);
+	for (uint64_t& key : keys) {
+		key = rng() & 0xFF00'0FFF'0000'00FF; // few distinct bytes, with duplicates
+	}
+	std::vector<uint32_t> values(keys.size());
+	std::iota(values.begin(), values.end(), 0);
+
+	std::vector<uint32_t> expected = values;
+	std::stable_sort(expected.begin(), expected.end(), [&](uint32_t lhs, uint32_t rhs) { return keys[lhs] < keys[rhs]; });
+	std::vector<uint64_t> expected_keys = keys;
+	std::sort(expected_keys.begin(), expected_keys.end());
+
+	RadixSorter sorter;
+	sorter.sort(&keys, &values);
+
+	EXPECT_EQ(keys, expected_keys);
+	EXPECT_EQ(values, expected);
+}
+
+TEST(RadixSortTests, Sort_EqualKeys_KeepsOrder) {
+	std::vector<uint64_t> keys = { 7, 7, 7, 7 };
+	std::vector<uint32_t> values = { 3, 1, 2, 0 };
+
+	RadixSorter sorter;
+	sorter.sort(&keys, &values);
+
+	EXPECT_EQ(values, (std::vector<uint32_t> { 3, 1, 2, 0 }));
+}
+
+TEST(RadixSortTests, Sort_HighBitsOnly) {
+	std::vector<uint64_t> keys = { 3ull << 56, 1ull << 56, 2ull << 56 };
+	std::vector<uint32_t> values = { 0, 1, 2 };
+
+	RadixSorter sorter;
+	sorter.sort(&keys, &values);
+
+	EXPECT_EQ(values, (std::vector<uint32_t> { 1, 2, 0 }));
+}
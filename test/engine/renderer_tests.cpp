@@ -7,6 +7,7 @@
 #include <engine/graphics/renderer.h>
 
 #include <cmath>
+#include <vector>
 #include <engine/math/math_defines.h>
 
 using namespace engine;
@@ -131,6 +132,46 @@ TEST_F(RendererTests, DrawLine_FixedColors_HalfAlpha) {
 	EXPECT_IMAGE_EQ_SNAPSHOT(renderer.bitmap().to_image());
 }
 
+TEST_F(RendererTests, DrawLine_ClipRect_MatchesUnclippedLines) {
+	const Rect clip = { 70, 50, 90, 60 };
+	auto draw_lines = [](Renderer* renderer) {
+		renderer->clear_screen(Color::black());
+		const IVec2 centers[] = { { 20, 15 }, { 115, 80 }, { 230, 190 } };
+		for (IVec2 center : centers) {
+			for (int32_t i = 0; i < 48; i++) {
+				const float angle = i * (2.0f * (float)M_PI / 48);
+				const IVec2 end = center + IVec2 { (int32_t)(200 * std::cos(angle)), (int32_t)(200 * std::sin(angle)) };
+				const IVec2 clamped_end = { std::clamp(end.x, 0, BITMAP_WIDTH - 1), std::clamp(end.y, 0, BITMAP_HEIGHT - 1) };
+				if (i % 2 == 0) {
+					renderer->draw_line(center, clamped_end, Color::green().with_alpha(0.5f));
+				}
+				else {
+					renderer->draw_line(Vertex { center, Color::red() }, Vertex { clamped_end, Color::blue().with_alpha(0.5f) });
+				}
+			}
+		}
+	};
+	Renderer clipped_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer unclipped_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+
+	clipped_renderer.clear_screen(Color::black());
+	clipped_renderer.push_clip_rect(clip);
+	draw_lines(&clipped_renderer);
+	clipped_renderer.pop_clip_rect();
+	draw_lines(&unclipped_renderer);
+	clipped_renderer.render(m_resources);
+	unclipped_renderer.render(m_resources);
+
+	Bitmap clipped = clipped_renderer.bitmap();
+	Bitmap unclipped = unclipped_renderer.bitmap();
+	for (int32_t y = 0; y < BITMAP_HEIGHT; y++) {
+		for (int32_t x = 0; x < BITMAP_WIDTH; x++) {
+			const Pixel expected = clip.contains(IVec2 { x, y }) ? unclipped.get(x, y) : Pixel::from_color(Color::black());
+			ASSERT_EQ(clipped.get(x, y), expected) << "at " << x << ", " << y;
+		}
+	}
+}
+
 TEST_F(RendererTests, DrawRect) {
 	Renderer renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
 
@@ -211,6 +252,29 @@ TEST_F(RendererTests, DrawCircleFill_HalfAlpha) {
 	EXPECT_IMAGE_EQ_SNAPSHOT(renderer.bitmap().to_image());
 }
 
+TEST_F(RendererTests, DrawCircle_LargeRadius_FollowsCircle) {
+	// Top of a circle far larger than the bitmap, so its midpoint terms don't fit in 32 bits
+	const int32_t radius = 40000;
+	const IVec2 center = { BITMAP_WIDTH / 2, BITMAP_HEIGHT / 2 + radius };
+	Renderer outline_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer fill_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	outline_renderer.clear_screen(Color::black());
+	fill_renderer.clear_screen(Color::black());
+	outline_renderer.draw_circle(center, radius, Color::green());
+	fill_renderer.draw_circle_fill(center, radius, Color::green());
+
+	outline_renderer.render(m_resources);
+	fill_renderer.render(m_resources);
+	const Image outline = outline_renderer.bitmap().to_image();
+	const Image fill = fill_renderer.bitmap().to_image();
+	for (int32_t dx : { -100, 0, 100 }) {
+		EXPECT_EQ(outline.get(center.x + dx, center.y - radius), Color::green());
+		EXPECT_EQ(outline.get(center.x + dx, center.y - radius + 1), Color::black());
+		EXPECT_EQ(fill.get(center.x + dx, center.y - radius + 1), Color::green());
+		EXPECT_EQ(fill.get(center.x + dx, center.y - radius - 1), Color::black());
+	}
+}
+
 TEST_F(RendererTests, DrawTriangle_EquilateralTriangle) {
 	Renderer renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
 
@@ -267,6 +331,152 @@ TEST_F(RendererTests, DrawTriangleFill_EquilateralTriangle_HalfAlpha) {
 	EXPECT_IMAGE_EQ_SNAPSHOT(renderer.bitmap().to_image());
 }
 
+TEST_F(RendererTests, DrawTriangleFill_SharedEdge_IsDrawnOnce) {
+	Renderer triangle_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer rect_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+
+	// two triangles covering a rect, the diagonal shouldn't get blended twice
+	Rect rect = { 40, 30, 150, 100 };
+	Color color = Color::red().with_alpha(0.5f);
+	Vertex top_left = { { rect.x, rect.y }, color };
+	Vertex top_right = { { rect.x + rect.width, rect.y }, color };
+	Vertex bottom_left = { { rect.x, rect.y + rect.height }, color };
+	Vertex bottom_right = { { rect.x + rect.width, rect.y + rect.height }, color };
+	triangle_renderer.draw_triangle_fill(top_left, top_right, bottom_right);
+	triangle_renderer.draw_triangle_fill(top_left, bottom_right, bottom_left);
+	rect_renderer.draw_rect_fill(rect, color);
+
+	triangle_renderer.render(m_resources);
+	rect_renderer.render(m_resources);
+	EXPECT_EQ(triangle_renderer.bitmap(), rect_renderer.bitmap());
+}
+
+TEST_F(RendererTests, DrawMesh_MatchesDrawTriangleFill) {
+	Renderer mesh_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer triangle_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+
+	// a fan of triangles around a center vertex
+	std::vector<Vertex> vertices = { Vertex { { 128, 120 }, Color::white() } };
+	std::vector<uint16_t> indices;
+	const Color colors[] = { Color::red(), Color::green().with_alpha(0.5f), Color::blue() };
+	for (int32_t i = 0; i < 12; i++) {
+		const float angle = i * (2.0f * (float)M_PI / 12);
+		vertices.push_back(Vertex { { 128 + (int32_t)(100 * std::cos(angle)), 120 + (int32_t)(100 * std::sin(angle)) }, colors[i % 3] });
+	}
+	for (uint16_t i = 1; i <= 12; i++) {
+		indices.insert(indices.end(), { 0, i, (uint16_t)(i % 12 + 1) });
+	}
+	mesh_renderer.draw_mesh(vertices, indices);
+	for (size_t i = 0; i < indices.size(); i += 3) {
+		triangle_renderer.draw_triangle_fill(vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]]);
+	}
+
+	mesh_renderer.render(m_resources);
+	triangle_renderer.render(m_resources);
+	EXPECT_EQ(mesh_renderer.bitmap(), triangle_renderer.bitmap());
+}
+
+TEST_F(RendererTests, DrawMesh_Textured_MultipliesImageColor) {
+	Renderer renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer expected_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	ImageID texture = renderer.create_render_target(16, 16);
+	renderer.begin_render_target(texture);
+	renderer.clear_screen(Color::green());
+	renderer.end_render_target();
+
+	const Rect rect = { 40, 30, 150, 100 };
+	const Vertex vertices[] = {
+		Vertex { { rect.x, rect.y }, Color::white(), { 0.0f, 1.0f } },
+		Vertex { { rect.x + rect.width, rect.y }, Color::white(), { 1.0f, 1.0f } },
+		Vertex { { rect.x + rect.width, rect.y + rect.height }, Color::white(), { 1.0f, 0.0f } },
+		Vertex { { rect.x, rect.y + rect.height }, Color::white(), { 0.0f, 0.0f } },
+	};
+	const uint16_t indices[] = { 0, 1, 2, 0, 2, 3 };
+	renderer.draw_mesh(vertices, indices, texture);
+	expected_renderer.draw_rect_fill(rect, Color::green());
+
+	renderer.render(m_resources);
+	expected_renderer.render(m_resources);
+	EXPECT_EQ(renderer.bitmap().to_image().pixels, expected_renderer.bitmap().to_image().pixels);
+}
+
+TEST_F(RendererTests, DrawPolyline_MatchesDrawLine) {
+	Renderer polyline_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer line_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+
+	std::vector<Vertex> vertices;
+	for (int32_t x = 0; x < BITMAP_WIDTH; x += 8) {
+		const int32_t y = 120 + (int32_t)(80 * std::sin(x * 0.05f));
+		vertices.push_back(Vertex { { x, y }, x % 16 == 0 ? Color::red() : Color::yellow() });
+	}
+	polyline_renderer.draw_polyline(vertices);
+	for (size_t i = 0; i + 1 < vertices.size(); i++) {
+		line_renderer.draw_line(vertices[i], vertices[i + 1]);
+	}
+
+	polyline_renderer.render(m_resources);
+	line_renderer.render(m_resources);
+	EXPECT_EQ(polyline_renderer.bitmap(), line_renderer.bitmap());
+}
+
+TEST_F(RendererTests, DrawPolyline_Translucent_BlendsJointsOnce) {
+	Renderer polyline_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer coverage_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer point_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	const Color color = Color::yellow().with_alpha(0.5f);
+
+	// axis aligned and diagonal lines that only meet at their shared points
+	const Vertex vertices[] = {
+		Vertex { { 20, 20 }, color },
+		Vertex { { 60, 20 }, color },
+		Vertex { { 60, 60 }, color },
+		Vertex { { 100, 100 }, color },
+		Vertex { { 140, 90 }, color },
+		Vertex { { 140, 50 }, color },
+		Vertex { { 200, 70 }, color },
+	};
+	polyline_renderer.clear_screen(Color::blue());
+	polyline_renderer.draw_polyline(vertices);
+	std::vector<Vertex> opaque_vertices(std::begin(vertices), std::end(vertices));
+	for (Vertex& vertex : opaque_vertices) {
+		vertex.color = Color::white();
+	}
+	coverage_renderer.clear_screen(Color::black());
+	coverage_renderer.draw_polyline(opaque_vertices);
+	point_renderer.clear_screen(Color::blue());
+	point_renderer.draw_rect_fill(Rect { 0, 0, 1, 1 }, color);
+
+	polyline_renderer.render(m_resources);
+	coverage_renderer.render(m_resources);
+	point_renderer.render(m_resources);
+	const Image polyline = polyline_renderer.bitmap().to_image();
+	const Image coverage = coverage_renderer.bitmap().to_image();
+	const Color blended_once = point_renderer.bitmap().to_image().get(0, 0);
+	for (int32_t y = 0; y < BITMAP_HEIGHT; y++) {
+		for (int32_t x = 0; x < BITMAP_WIDTH; x++) {
+			const Color expected = coverage.get(x, y) == Color::white() ? blended_once : Color::blue();
+			ASSERT_EQ(polyline.get(x, y), expected) << "at " << x << ", " << y;
+		}
+	}
+}
+
+TEST_F(RendererTests, DrawMesh_IndexOutOfRange_IsntDrawn) {
+	Renderer mesh_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer empty_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+
+	const Vertex vertices[] = {
+		Vertex { { 20, 20 }, Color::red() },
+		Vertex { { 120, 20 }, Color::red() },
+		Vertex { { 20, 120 }, Color::red() },
+	};
+	const uint16_t indices[] = { 0, 1, 2, 0, 2, 3 };
+	mesh_renderer.draw_mesh(vertices, indices);
+
+	mesh_renderer.render(m_resources);
+	empty_renderer.render(m_resources);
+	EXPECT_EQ(mesh_renderer.bitmap(), empty_renderer.bitmap());
+}
+
 TEST_F(RendererTests, DrawImage) {
 	Renderer renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
 
@@ -522,6 +732,66 @@ TEST_F(RendererTests, DrawImageScaled_Clipped_BottomRight) {
 	EXPECT_IMAGE_EQ_SNAPSHOT(renderer.bitmap().to_image());
 }
 
+TEST_F(RendererTests, DrawSprites_MatchesDrawImage) {
+	ImageID sheet = m_resources.load_image("assets/image/render_test/sprite_sheet.png");
+	ASSERT_NE(sheet, INVALID_IMAGE_ID) << "Failed to load sprite sheet!";
+	Renderer sprite_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer tiled_sprite_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer image_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	tiled_sprite_renderer.set_tiled_rendering(true, 4);
+
+	std::vector<Rect> clips;
+	for (int32_t i = 0; i < 6; i++) {
+		clips.push_back(Rect { i * 16, 0, 16, 16 });
+	}
+	clips.push_back(Rect { 20, 2, 40, 12 }); // spanning several frames
+	std::vector<SpriteInstance> instances;
+	const uint8_t alphas[] = { 255, 255, 128, 0, 200 };
+	for (int32_t i = 0; i < 200; i++) {
+		// some sprites are partly off screen
+		const IVec2 pos = { (i * 37) % (BITMAP_WIDTH + 16) - 16, (i * 53) % (BITMAP_HEIGHT + 16) - 8 };
+		instances.push_back(SpriteInstance { pos, (uint16_t)(i % clips.size()), (uint8_t)(i % 4), alphas[i % 5] });
+	}
+	for (Renderer* renderer : { &sprite_renderer, &tiled_sprite_renderer }) {
+		renderer->clear_screen(Color::blue());
+		renderer->set_sprite_clips(sheet, clips);
+		renderer->draw_sprites(sheet, instances);
+		renderer->render(m_resources);
+	}
+	image_renderer.clear_screen(Color::blue());
+	for (const SpriteInstance& instance : instances) {
+		image_renderer.draw_image(sheet, instance.pos, DrawImageOptions {
+			.clip = clips[instance.clip_index],
+			.flip_h = (instance.flags & SPRITE_FLIP_H) != 0,
+			.flip_v = (instance.flags & SPRITE_FLIP_V) != 0,
+			.alpha = instance.alpha / 255.0f,
+		});
+	}
+
+	image_renderer.render(m_resources);
+	EXPECT_EQ(sprite_renderer.bitmap().to_image().pixels, image_renderer.bitmap().to_image().pixels);
+	EXPECT_EQ(tiled_sprite_renderer.bitmap().to_image().pixels, image_renderer.bitmap().to_image().pixels);
+}
+
+TEST_F(RendererTests, DrawSprites_ClipsChangedAfterRecording_DrawRecordedClips) {
+	ImageID sheet = m_resources.load_image("assets/image/render_test/sprite_sheet.png");
+	Renderer sprite_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer image_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+
+	const std::vector<Rect> clips = { Rect { 16, 0, 16, 16 }, Rect { 32, 0, 16, 16 } };
+	const SpriteInstance instances[] = { { IVec2 { 20, 30 }, 0 }, { IVec2 { 60, 30 }, 1 } };
+	sprite_renderer.set_sprite_clips(sheet, clips);
+	sprite_renderer.draw_sprites(sheet, instances);
+	sprite_renderer.set_sprite_clips(sheet, std::vector<Rect> { Rect { 0, 0, 8, 8 } });
+	for (const SpriteInstance& instance : instances) {
+		image_renderer.draw_image(sheet, instance.pos, { .clip = clips[instance.clip_index] });
+	}
+
+	sprite_renderer.render(m_resources);
+	image_renderer.render(m_resources);
+	EXPECT_EQ(sprite_renderer.bitmap().to_image().pixels, image_renderer.bitmap().to_image().pixels);
+}
+
 TEST_F(RendererTests, DrawFont_HorizontallyLeftAligned) {
 	Renderer renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
 
@@ -566,3 +836,661 @@ TEST_F(RendererTests, DrawFont_HorizontallyRightAligned) {
 	renderer.render(m_resources);
 	EXPECT_IMAGE_EQ_SNAPSHOT(renderer.bitmap().to_image());
 }
+
+TEST_F(RendererTests, TiledRendering_MatchesSerialRendering) {
+	Renderer serial_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer tiled_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	tiled_renderer.set_tiled_rendering(true, 4);
+
+	auto draw_scene = [this](Renderer* renderer) {
+		const Image& image = m_resources.image(m_test_image_id);
+		renderer->clear_screen(Color::turquoise());
+		renderer->draw_rect_fill(Rect { 10, 10, 100, 70 }, Color::red().with_alpha(0.5f));
+		renderer->draw_rect(Rect { 20, 20, 200, 150 }, Color::yellow());
+		renderer->draw_line(IVec2 { -10, 5 }, IVec2 { BITMAP_WIDTH + 10, BITMAP_HEIGHT - 5 }, Color::blue().with_alpha(0.5f));
+		renderer->draw_circle(IVec2 { 64, 160 }, 50, Color::green());
+		renderer->draw_circle_fill(IVec2 { 190, 64 }, 40, Color::purple().with_alpha(0.5f));
+		renderer->draw_triangle_fill(Vertex { { 128, 30 }, Color::red() }, Vertex { { 60, 200 }, Color::green() }, Vertex { { 230, 180 }, Color::blue().with_alpha(0.5f) });
+		renderer->draw_image(m_test_image_id, IVec2 { 100, 100 }, { .flip_h = true, .alpha = 0.5f });
+		renderer->draw_image_scaled(m_test_image_id, Rect { 150, 120, 2 * image.width, 2 * image.height }, { .tint = Color { 255, 0, 0, 127 } });
+		renderer->draw_text(m_test_font_id, TEST_FONT_SIZE, Rect { 30, 40, 180, 160 }, Color::white(), LOREM_IPSUM, { .h_alignment = HorizontalAlignment::Center });
+	};
+	draw_scene(&serial_renderer);
+	draw_scene(&tiled_renderer);
+
+	serial_renderer.render(m_resources);
+	tiled_renderer.render(m_resources);
+	EXPECT_EQ(serial_renderer.bitmap(), tiled_renderer.bitmap());
+}
+
+TEST_F(RendererTests, DirtyRectTracking_UnchangedFrame_HasNoDirtyRects) {
+	Renderer renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	renderer.set_dirty_rect_tracking(true);
+
+	for (int frame = 0; frame < 2; frame++) {
+		renderer.clear_screen(Color::turquoise());
+		renderer.draw_rect_fill(Rect { 10, 10, 100, 70 }, Color::red());
+		renderer.draw_text(m_test_font_id, TEST_FONT_SIZE, Rect { 30, 40, 180, 160 }, Color::white(), "Paused");
+		renderer.render(m_resources);
+	}
+
+	EXPECT_TRUE(renderer.dirty_rects().empty());
+}
+
+TEST_F(RendererTests, DirtyRectTracking_MovedRect_MatchesFullRendering) {
+	Renderer full_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer tracking_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	tracking_renderer.set_dirty_rect_tracking(true);
+
+	auto draw_scene = [this](Renderer* renderer, IVec2 rect_pos) {
+		renderer->clear_screen(Color::turquoise());
+		renderer->draw_circle_fill(IVec2 { 190, 64 }, 40, Color::purple().with_alpha(0.5f));
+		renderer->draw_rect_fill(Rect { rect_pos.x, rect_pos.y, 20, 20 }, Color::red().with_alpha(0.5f));
+		renderer->draw_text(m_test_font_id, TEST_FONT_SIZE, Rect { 30, 140, 180, 60 }, Color::white(), LOREM_IPSUM);
+	};
+	draw_scene(&tracking_renderer, IVec2 { 10, 10 });
+	tracking_renderer.render(m_resources);
+	ASSERT_EQ(tracking_renderer.dirty_rects().size(), 1);
+	EXPECT_EQ(tracking_renderer.dirty_rects()[0].width, BITMAP_WIDTH);
+	EXPECT_EQ(tracking_renderer.dirty_rects()[0].height, BITMAP_HEIGHT);
+
+	draw_scene(&tracking_renderer, IVec2 { 40, 10 });
+	draw_scene(&full_renderer, IVec2 { 40, 10 });
+	tracking_renderer.render(m_resources);
+	full_renderer.render(m_resources);
+
+	EXPECT_EQ(tracking_renderer.bitmap(), full_renderer.bitmap());
+	ASSERT_EQ(tracking_renderer.dirty_rects().size(), 1);
+	EXPECT_EQ(tracking_renderer.dirty_rects()[0].x, 0);
+	EXPECT_EQ(tracking_renderer.dirty_rects()[0].y, 0);
+	EXPECT_EQ(tracking_renderer.dirty_rects()[0].width, 2 * 32);
+	EXPECT_EQ(tracking_renderer.dirty_rects()[0].height, 32);
+}
+
+TEST_F(RendererTests, FrameSkipping_UnchangedFrame_IsSkipped) {
+	Renderer renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	renderer.set_frame_skipping(true);
+
+	for (int frame = 0; frame < 3; frame++) {
+		renderer.clear_screen(Color::turquoise());
+		renderer.draw_rect_fill(Rect { 10, 10, 100, 70 }, Color::red().with_alpha(0.5f));
+		renderer.draw_text(m_test_font_id, TEST_FONT_SIZE, Rect { 30, 40, 180, 160 }, Color::white(), "Paused");
+		renderer.render(m_resources);
+	}
+
+	EXPECT_EQ(renderer.num_skipped_frames(), 2);
+	EXPECT_TRUE(renderer.dirty_rects().empty());
+}
+
+TEST_F(RendererTests, FrameSkipping_ChangedFrames_MatchFullRendering) {
+	Renderer full_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer skipping_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	skipping_renderer.set_frame_skipping(true);
+	ImageID full_target = full_renderer.create_render_target(64, 64);
+	ImageID skipping_target = skipping_renderer.create_render_target(64, 64);
+
+	// Each frame changes either a screen command, a render target or nothing
+	const std::vector<std::pair<IVec2, Color>> frames = {
+		{ IVec2 { 10, 10 }, Color::red() },
+		{ IVec2 { 40, 10 }, Color::red() },
+		{ IVec2 { 40, 10 }, Color::green() },
+		{ IVec2 { 40, 10 }, Color::green() },
+	};
+	for (auto [rect_pos, target_color] : frames) {
+		for (auto [renderer, target] : { std::pair { &full_renderer, full_target }, std::pair { &skipping_renderer, skipping_target } }) {
+			renderer->begin_render_target(target);
+			renderer->clear_screen(target_color);
+			renderer->end_render_target();
+			renderer->clear_screen(Color::turquoise());
+			renderer->draw_image(target, IVec2 { 100, 40 }, { .alpha = 0.5f });
+			renderer->draw_rect_fill(Rect { rect_pos.x, rect_pos.y, 20, 20 }, Color::blue());
+			renderer->render(m_resources);
+		}
+		EXPECT_EQ(skipping_renderer.bitmap(), full_renderer.bitmap());
+	}
+	EXPECT_EQ(skipping_renderer.num_skipped_frames(), 1);
+}
+
+TEST_F(RendererTests, FrameSkipping_EditedTileMap_IsRedrawn) {
+	ImageID tileset_id = m_resources.load_image("assets/image/render_test/sprite_sheet.png");
+	TileMapID tilemap_id = m_resources.add_tilemap(TileMap::with_size(tileset_id, IVec2 { 16, 16 }, IVec2 { 20, 15 }));
+	TileMap& tilemap = m_resources.tilemap(tilemap_id);
+	for (int32_t y = 0; y < tilemap.size().y; y++) {
+		for (int32_t x = 0; x < tilemap.size().x; x++) {
+			tilemap.set_tile(x, y, (uint16_t)((x + y) % 6));
+		}
+	}
+
+	Renderer full_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer skipping_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer dirty_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	skipping_renderer.set_frame_skipping(true);
+	dirty_renderer.set_dirty_rect_tracking(true);
+	for (int32_t frame = 0; frame < 3; frame++) {
+		// Commands stay the same, only the tile map changes between frames
+		tilemap.set_tile(3 + frame, 4, (uint16_t)(frame % 2 == 0 ? 5 : TileMap::EMPTY_TILE));
+		for (Renderer* renderer : { &full_renderer, &skipping_renderer, &dirty_renderer }) {
+			renderer->clear_screen(Color::turquoise());
+			renderer->draw_tilemap(tilemap_id, IVec2 { 0, 0 });
+			renderer->render(m_resources);
+		}
+		EXPECT_EQ(skipping_renderer.bitmap(), full_renderer.bitmap()) << "frame " << frame;
+		EXPECT_EQ(dirty_renderer.bitmap(), full_renderer.bitmap()) << "frame " << frame;
+		if (frame > 0) {
+			EXPECT_FALSE(dirty_renderer.dirty_rects().empty()) << "frame " << frame;
+		}
+	}
+	EXPECT_EQ(skipping_renderer.num_skipped_frames(), 0);
+}
+
+TEST_F(RendererTests, DrawLayer_MatchesManuallyOrderedDraws) {
+	Renderer layered_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer ordered_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+
+	layered_renderer.set_draw_layer(1);
+	layered_renderer.draw_text(m_test_font_id, TEST_FONT_SIZE, Rect { 30, 40, 180, 160 }, Color::white(), "Paused");
+	layered_renderer.set_draw_layer(0, 50);
+	layered_renderer.draw_image(m_test_image_id, IVec2 { 40, 34 }, { .alpha = 0.5f });
+	layered_renderer.set_draw_layer(0, 20);
+	layered_renderer.draw_image(m_test_image_id, IVec2 { 30, 4 }, { .alpha = 0.5f });
+	layered_renderer.set_draw_layer(-1);
+	layered_renderer.clear_screen(Color::turquoise());
+
+	ordered_renderer.clear_screen(Color::turquoise());
+	ordered_renderer.draw_image(m_test_image_id, IVec2 { 30, 4 }, { .alpha = 0.5f });
+	ordered_renderer.draw_image(m_test_image_id, IVec2 { 40, 34 }, { .alpha = 0.5f });
+	ordered_renderer.draw_text(m_test_font_id, TEST_FONT_SIZE, Rect { 30, 40, 180, 160 }, Color::white(), "Paused");
+
+	layered_renderer.render(m_resources);
+	ordered_renderer.render(m_resources);
+	EXPECT_EQ(layered_renderer.bitmap(), ordered_renderer.bitmap());
+}
+
+TEST_F(RendererTests, DrawLayer_SameDepthRenderTargets_AreBatchedAfterShapes) {
+	Renderer layered_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer ordered_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	for (Renderer* renderer : { &layered_renderer, &ordered_renderer }) {
+		const ImageID red_target = renderer->create_render_target(48, 48);
+		const ImageID green_target = renderer->create_render_target(48, 48);
+		for (auto [target, color] : { std::pair { red_target, Color::red() }, std::pair { green_target, Color::green() } }) {
+			renderer->begin_render_target(target);
+			renderer->clear_screen(color);
+			renderer->end_render_target();
+		}
+		renderer->clear_screen(Color::turquoise());
+	}
+
+	// Shapes aren't batched, so they go first, then images by id with targets last
+	const ImageID red_target = ImageID(-1);
+	const ImageID green_target = ImageID(-2);
+	const DrawImageOptions translucent = { .alpha = 0.5f };
+	layered_renderer.set_draw_layer(0, 10);
+	layered_renderer.draw_image(red_target, IVec2 { 20, 20 }, translucent);
+	layered_renderer.draw_rect_fill(Rect { 30, 30, 40, 40 }, Color::blue().with_alpha(0.5f));
+	layered_renderer.draw_image(green_target, IVec2 { 35, 25 }, translucent);
+	layered_renderer.draw_rect_fill(Rect { 40, 20, 40, 40 }, Color::yellow().with_alpha(0.5f));
+	layered_renderer.draw_image(red_target, IVec2 { 50, 40 }, translucent);
+	layered_renderer.draw_image(m_test_image_id, IVec2 { 45, 35 }, translucent);
+	layered_renderer.draw_image(green_target, IVec2 { 25, 45 }, translucent);
+
+	ordered_renderer.draw_rect_fill(Rect { 30, 30, 40, 40 }, Color::blue().with_alpha(0.5f));
+	ordered_renderer.draw_rect_fill(Rect { 40, 20, 40, 40 }, Color::yellow().with_alpha(0.5f));
+	ordered_renderer.draw_image(m_test_image_id, IVec2 { 45, 35 }, translucent);
+	ordered_renderer.draw_image(red_target, IVec2 { 20, 20 }, translucent);
+	ordered_renderer.draw_image(red_target, IVec2 { 50, 40 }, translucent);
+	ordered_renderer.draw_image(green_target, IVec2 { 35, 25 }, translucent);
+	ordered_renderer.draw_image(green_target, IVec2 { 25, 45 }, translucent);
+
+	layered_renderer.render(m_resources);
+	ordered_renderer.render(m_resources);
+	EXPECT_EQ(layered_renderer.bitmap().to_image().pixels, ordered_renderer.bitmap().to_image().pixels);
+}
+
+TEST_F(RendererTests, DrawImage_SpriteRuns_MatchUnscaledDrawImageScaled) {
+	ImageID sprite_sheet_id = m_resources.load_image("assets/image/render_test/sprite_sheet.png");
+	ASSERT_TRUE(m_resources.image(sprite_sheet_id).has_runs());
+
+	const Rect clip = { 16, 0, 16, 16 };
+	const std::vector<DrawImageOptions> options_to_test = {
+		{ .clip = clip },
+		{ .clip = clip, .flip_h = true },
+		{ .clip = clip, .flip_v = true, .alpha = 0.5f },
+		{ .clip = clip, .flip_h = true, .tint = Color::red().with_alpha(0.5f) },
+	};
+	for (DrawImageOptions options : options_to_test) {
+		Renderer run_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+		Renderer scaled_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+		run_renderer.clear_screen(Color::turquoise());
+		scaled_renderer.clear_screen(Color::turquoise());
+
+		run_renderer.draw_image(sprite_sheet_id, IVec2 { -4, 10 }, options);
+		scaled_renderer.draw_image_scaled(sprite_sheet_id, Rect { -4, 10, clip.width, clip.height }, options);
+
+		run_renderer.render(m_resources);
+		scaled_renderer.render(m_resources);
+		EXPECT_EQ(run_renderer.bitmap(), scaled_renderer.bitmap()) << "flip_h = " << options.flip_h << ", flip_v = " << options.flip_v;
+	}
+}
+
+TEST_F(RendererTests, DrawImage_TransformedImageCache_MatchesUncached) {
+	ImageID sprite_sheet_id = m_resources.load_image("assets/image/render_test/sprite_sheet.png");
+	const std::vector<DrawImageOptions> options_to_test = {
+		{ .flip_h = true },
+		{ .clip = Rect { 16, 0, 16, 16 }, .flip_v = true, .alpha = 0.5f },
+		{ .clip = Rect { 16, 0, 16, 16 }, .flip_h = true, .tint = Color::red().with_alpha(0.5f) },
+	};
+	Renderer cached_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer uncached_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	uncached_renderer.set_transformed_image_budget(0);
+	for (int frame = 0; frame < 2; frame++) {
+		for (Renderer* renderer : { &cached_renderer, &uncached_renderer }) {
+			renderer->clear_screen(Color::turquoise());
+			for (size_t i = 0; i < options_to_test.size(); i++) {
+				renderer->draw_image(sprite_sheet_id, IVec2 { -4 + 40 * (int32_t)i, 10 }, options_to_test[i]);
+			}
+			renderer->render(m_resources);
+		}
+		EXPECT_EQ(cached_renderer.bitmap(), uncached_renderer.bitmap()) << "frame = " << frame;
+	}
+	EXPECT_EQ(cached_renderer.transformed_image_cache().stats().misses, 3);
+	EXPECT_EQ(cached_renderer.transformed_image_cache().stats().hits, 3);
+	EXPECT_EQ(uncached_renderer.transformed_image_cache().size(), 0);
+}
+
+TEST_F(RendererTests, ClipRect_MatchesManuallyClippedDraws) {
+	Renderer clipped_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer manual_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+
+	clipped_renderer.clear_screen(Color::turquoise());
+	clipped_renderer.push_clip_rect(Rect { 40, 30, 100, 80 });
+	clipped_renderer.draw_rect_fill(Rect { 0, 0, BITMAP_WIDTH, BITMAP_HEIGHT }, Color::white());
+	clipped_renderer.push_clip_rect(Rect { 0, 0, 60, 60 });
+	clipped_renderer.clear_screen(Color::red());
+	clipped_renderer.draw_image(m_test_image_id, IVec2 { 200, 150 });
+	clipped_renderer.pop_clip_rect();
+	clipped_renderer.pop_clip_rect();
+
+	manual_renderer.clear_screen(Color::turquoise());
+	manual_renderer.draw_rect_fill(Rect { 40, 30, 100, 80 }, Color::white());
+	manual_renderer.draw_rect_fill(Rect { 40, 30, 20, 30 }, Color::red());
+
+	clipped_renderer.render(m_resources);
+	manual_renderer.render(m_resources);
+	EXPECT_EQ(clipped_renderer.bitmap(), manual_renderer.bitmap());
+}
+
+TEST_F(RendererTests, Culling_PartiallyVisibleDraws_AreKept) {
+	const Image& image = m_resources.image(m_test_image_id);
+	const Rect image_rect = { 4 - image.width, 4 - image.height, image.width, image.height };
+	const int32_t text_width = m_resources.typeface(m_test_font_id).text_width(TEST_FONT_SIZE, "Hello");
+	Renderer unsized_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer sized_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	for (Renderer* renderer : { &unsized_renderer, &sized_renderer }) {
+		renderer->clear_screen(Color::turquoise());
+		renderer->draw_circle_fill(IVec2 { -10, BITMAP_HEIGHT / 2 }, 12, Color::red());
+		renderer->draw_line(IVec2 { 0, -1 }, IVec2 { BITMAP_WIDTH + 20, -1 }, Color::red()); // off-screen
+	}
+
+	// Images and text without a size are kept even though their size isn't known when recorded
+	unsized_renderer.draw_image(m_test_image_id, image_rect.pos());
+	unsized_renderer.draw_text(m_test_font_id, TEST_FONT_SIZE, Rect { BITMAP_WIDTH - 8, BITMAP_HEIGHT - 8 }, Color::white(), "Hello");
+	sized_renderer.draw_image_scaled(m_test_image_id, image_rect);
+	sized_renderer.draw_text(m_test_font_id, TEST_FONT_SIZE, Rect { BITMAP_WIDTH - 8, BITMAP_HEIGHT - 8, text_width, 0 }, Color::white(), "Hello");
+
+	unsized_renderer.render(m_resources);
+	sized_renderer.render(m_resources);
+	EXPECT_EQ(unsized_renderer.bitmap(), sized_renderer.bitmap());
+}
+
+TEST_F(RendererTests, RenderTarget_MatchesDrawingDirectly) {
+	const Rect panel = { 30, 20, 120, 90 };
+	auto draw_panel = [&](Renderer* renderer, IVec2 offset) {
+		renderer->clear_screen(Color::dark_purple());
+		renderer->draw_rect_fill(Rect { offset.x + 10, offset.y + 10, 40, 30 }, Color::red().with_alpha(0.5f));
+		renderer->draw_circle(offset + IVec2 { 100, 70 }, 30, Color::yellow());
+		renderer->draw_text(m_test_font_id, TEST_FONT_SIZE, Rect { offset.x + 4, offset.y + 50, 110, 40 }, Color::white(), "Inventory");
+	};
+	Renderer target_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer direct_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	ImageID target = target_renderer.create_render_target(panel.width, panel.height);
+
+	target_renderer.begin_render_target(target);
+	draw_panel(&target_renderer, IVec2 { 0, 0 });
+	target_renderer.end_render_target();
+	target_renderer.clear_screen(Color::turquoise());
+	target_renderer.draw_image(target, panel.pos());
+
+	direct_renderer.clear_screen(Color::turquoise());
+	direct_renderer.push_clip_rect(panel);
+	draw_panel(&direct_renderer, panel.pos());
+	direct_renderer.pop_clip_rect();
+
+	target_renderer.render(m_resources);
+	direct_renderer.render(m_resources);
+	// Compared as images since the screen's alpha channel isn't meaningful
+	EXPECT_EQ(target_renderer.bitmap().to_image().pixels, direct_renderer.bitmap().to_image().pixels);
+
+	// Target keeps its pixels for following frames
+	target_renderer.clear_screen(Color::turquoise());
+	target_renderer.draw_image(target, panel.pos());
+	target_renderer.render(m_resources);
+	EXPECT_EQ(target_renderer.bitmap().to_image().pixels, direct_renderer.bitmap().to_image().pixels);
+}
+
+TEST_F(RendererTests, RenderTarget_Redrawn_UpdatesDirtyTiles) {
+	Renderer tracked_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer full_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	tracked_renderer.set_dirty_rect_tracking(true);
+	ImageID tracked_target = tracked_renderer.create_render_target(64, 64);
+	ImageID full_target = full_renderer.create_render_target(64, 64);
+	for (Color color : { Color::red(), Color::green() }) {
+		for (auto [renderer, target] : { std::pair { &tracked_renderer, tracked_target }, std::pair { &full_renderer, full_target } }) {
+			renderer->begin_render_target(target);
+			renderer->clear_screen(color);
+			renderer->end_render_target();
+			renderer->clear_screen(Color::turquoise());
+			renderer->draw_image(target, IVec2 { 40, 40 }, { .flip_h = true, .alpha = 0.5f });
+			renderer->render(m_resources);
+		}
+		EXPECT_EQ(tracked_renderer.bitmap(), full_renderer.bitmap());
+		EXPECT_FALSE(tracked_renderer.dirty_rects().empty());
+	}
+}
+
+TEST_F(RendererTests, OcclusionCulling_MatchesUnculledRenderTarget) {
+	// Render targets aren't culled, so they show what the screen should look like
+	auto draw_scene = [&](Renderer* renderer, ImageID opaque_image) {
+		renderer->clear_screen(Color::turquoise());
+		renderer->draw_circle_fill(IVec2 { 60, 50 }, 40, Color::purple().with_alpha(0.5f));
+		renderer->draw_text(m_test_font_id, TEST_FONT_SIZE, Rect { 10, 20, 180, 60 }, Color::white(), LOREM_IPSUM);
+		renderer->draw_rect_fill(Rect { 0, 0, BITMAP_WIDTH, 30 }, Color::red());
+		renderer->draw_image(opaque_image, IVec2 { 20, 10 });
+		renderer->draw_image_scaled(opaque_image, Rect { 100, 60, 128, 96 }, { .flip_h = true });
+		renderer->draw_rect_fill(Rect { 90, 50, 40, 40 }, Color::yellow().with_alpha(0.5f));
+	};
+	auto draw_opaque_image = [](Renderer* renderer, ImageID target) {
+		renderer->begin_render_target(target);
+		renderer->clear_screen(Color::dark_green());
+		renderer->draw_circle(IVec2 { 32, 24 }, 20, Color::white());
+		renderer->end_render_target();
+	};
+	Renderer culled_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer unculled_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	ImageID culled_image = culled_renderer.create_render_target(64, 48);
+	ImageID unculled_image = unculled_renderer.create_render_target(64, 48);
+	ImageID unculled_target = unculled_renderer.create_render_target(BITMAP_WIDTH, BITMAP_HEIGHT);
+
+	draw_opaque_image(&culled_renderer, culled_image);
+	draw_scene(&culled_renderer, culled_image);
+	culled_renderer.render(m_resources);
+
+	draw_opaque_image(&unculled_renderer, unculled_image);
+	unculled_renderer.begin_render_target(unculled_target);
+	draw_scene(&unculled_renderer, unculled_image);
+	unculled_renderer.end_render_target();
+	unculled_renderer.draw_image(unculled_target, IVec2 { 0, 0 });
+	unculled_renderer.render(m_resources);
+
+	// Compared as images since the screen's alpha channel isn't meaningful
+	EXPECT_EQ(culled_renderer.bitmap().to_image().pixels, unculled_renderer.bitmap().to_image().pixels);
+}
+
+TEST_F(RendererTests, OcclusionCulling_ChangesBehindOpaqueRect_AreNotRedrawn) {
+	Renderer renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	renderer.set_dirty_rect_tracking(true);
+
+	for (int32_t x : { 10, 50 }) {
+		renderer.clear_screen(Color::turquoise());
+		renderer.draw_rect_fill(Rect { x, 10, 20, 20 }, Color::red().with_alpha(0.5f));
+		renderer.draw_rect_fill(Rect { 0, 0, 100, 100 }, Color::blue());
+		renderer.render(m_resources);
+	}
+
+	EXPECT_TRUE(renderer.dirty_rects().empty());
+}
+
+TEST_F(RendererTests, DrawTileMap_MatchesDrawImagePerTile) {
+	ImageID tileset_id = m_resources.load_image("assets/image/render_test/sprite_sheet.png");
+	const Image& tileset = m_resources.image(tileset_id);
+	const IVec2 tile_size = { 16, 16 };
+	const int32_t tileset_columns = tileset.width / tile_size.x;
+	const int32_t num_tiles = tileset_columns * (tileset.height / tile_size.y);
+	TileMapID tilemap_id = m_resources.add_tilemap(TileMap::with_size(tileset_id, tile_size, IVec2 { 40, 20 }));
+	TileMap& tilemap = m_resources.tilemap(tilemap_id);
+	for (int32_t y = 0; y < tilemap.size().y; y++) {
+		for (int32_t x = 0; x < tilemap.size().x; x++) {
+			if ((x + y) % 7 != 0) {
+				tilemap.set_tile(x, y, (uint16_t)((x * 3 + y) % num_tiles));
+			}
+		}
+	}
+
+	Renderer tilemap_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	for (IVec2 camera_offset : { IVec2 { 200, 37 }, IVec2 { 205, 37 }, IVec2 { -20, -10 } }) {
+		Renderer image_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+		image_renderer.clear_screen(Color::turquoise());
+		for (int32_t y = 0; y < tilemap.size().y; y++) {
+			for (int32_t x = 0; x < tilemap.size().x; x++) {
+				uint16_t tile = tilemap.tile(x, y);
+				if (tile != TileMap::EMPTY_TILE) {
+					IVec2 pos = { x * tile_size.x - camera_offset.x, y * tile_size.y - camera_offset.y };
+					Rect clip = { (tile % tileset_columns) * tile_size.x, (tile / tileset_columns) * tile_size.y, tile_size.x, tile_size.y };
+					image_renderer.draw_image(tileset_id, pos, { .clip = clip });
+				}
+			}
+		}
+		tilemap_renderer.clear_screen(Color::turquoise());
+		tilemap_renderer.draw_tilemap(tilemap_id, camera_offset);
+
+		image_renderer.render(m_resources);
+		tilemap_renderer.render(m_resources);
+		EXPECT_EQ(tilemap_renderer.bitmap(), image_renderer.bitmap()) << "camera_offset = " << camera_offset.x << ", " << camera_offset.y;
+
+		// Changed tiles show up in the next frame
+		tilemap.set_tile(15, 5, 0);
+	}
+}
+
+TEST_F(RendererTests, DrawTileMap_ScrollBuffer_MatchesChunks) {
+	ImageID tileset_id = m_resources.load_image("assets/image/render_test/sprite_sheet.png");
+	const Image& tileset = m_resources.image(tileset_id);
+	const int32_t num_tiles = (tileset.width / 16) * (tileset.height / 16);
+	TileMapID tilemap_id = m_resources.add_tilemap(TileMap::with_size(tileset_id, IVec2 { 16, 16 }, IVec2 { 40, 30 }));
+	TileMap& tilemap = m_resources.tilemap(tilemap_id);
+	for (int32_t y = 0; y < tilemap.size().y; y++) {
+		for (int32_t x = 0; x < tilemap.size().x; x++) {
+			tilemap.set_tile(x, y, (uint16_t)((x * 5 + y * 3) % num_tiles));
+		}
+	}
+
+	Renderer chunk_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer scroll_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	for (IVec2 camera_offset : { IVec2 { 0, 0 }, IVec2 { 3, 1 }, IVec2 { 19, 1 }, IVec2 { 157, 90 }, IVec2 { -30, -20 } }) {
+		tilemap.set_tile(camera_offset.x / 16 + 2, camera_offset.y / 16 + 2, 0);
+		for (auto [renderer, caching] : { std::pair { &chunk_renderer, TileMapCaching::Chunks }, std::pair { &scroll_renderer, TileMapCaching::ScrollBuffer } }) {
+			renderer->clear_screen(Color::turquoise());
+			renderer->draw_tilemap(tilemap_id, camera_offset, caching);
+			renderer->render(m_resources);
+		}
+		EXPECT_EQ(scroll_renderer.bitmap(), chunk_renderer.bitmap()) << "camera_offset = " << camera_offset.x << ", " << camera_offset.y;
+	}
+}
+
+TEST_F(RendererTests, DrawTileMap_ChangedTilesetOrSize_IsRedrawn) {
+	Renderer tilemap_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	const ImageID tileset_id = tilemap_renderer.create_render_target(16, 16);
+	TileMapID tilemap_id = m_resources.add_tilemap(TileMap::with_size(tileset_id, IVec2 { 16, 16 }, IVec2 { 4, 4 }));
+	m_resources.tilemap(tilemap_id).set_tile(1, 1, 0);
+
+	for (TileMapCaching caching : { TileMapCaching::Chunks, TileMapCaching::ScrollBuffer }) {
+		for (int32_t frame = 0; frame < 3; frame++) {
+			// Redrawn tileset without tile edits, then a new tile map with the same version but a different size
+			const Color tile_color = frame == 0 ? Color::red() : Color::green();
+			const IVec2 map_size = frame < 2 ? IVec2 { 4, 4 } : IVec2 { 8, 8 };
+			if (frame == 2) {
+				m_resources.tilemap(tilemap_id) = TileMap::with_size(tileset_id, IVec2 { 16, 16 }, map_size);
+				m_resources.tilemap(tilemap_id).set_tile(6, 6, 0);
+			}
+			tilemap_renderer.begin_render_target(tileset_id);
+			tilemap_renderer.clear_screen(tile_color);
+			tilemap_renderer.end_render_target();
+			tilemap_renderer.clear_screen(Color::black());
+			tilemap_renderer.draw_tilemap(tilemap_id, IVec2 { 0, 0 }, caching);
+			tilemap_renderer.render(m_resources);
+
+			const IVec2 tile = frame < 2 ? IVec2 { 1, 1 } : IVec2 { 6, 6 };
+			const Image image = tilemap_renderer.bitmap().to_image();
+			EXPECT_EQ(image.get(tile.x * 16 + 8, tile.y * 16 + 8), tile_color) << "frame " << frame << ", caching " << (int)caching;
+		}
+		tilemap_id = m_resources.add_tilemap(TileMap::with_size(tileset_id, IVec2 { 16, 16 }, IVec2 { 4, 4 }));
+		m_resources.tilemap(tilemap_id).set_tile(1, 1, 0);
+	}
+}
+
+TEST_F(RendererTests, DrawTileMap_ReplacedInPlace_IsRedrawn) {
+	const ImageID tileset_id = m_resources.load_image("assets/image/render_test/sprite_sheet.png");
+	auto fully_tiled_level = [&](uint16_t tile) {
+		// Every chunk ends up at the same version for both levels
+		TileMap level = TileMap::with_size(tileset_id, IVec2 { 16, 16 }, IVec2 { 20, 20 });
+		for (int32_t y = 0; y < level.size().y; y++) {
+			for (int32_t x = 0; x < level.size().x; x++) {
+				level.set_tile(x, y, tile);
+			}
+		}
+		return level;
+	};
+
+	for (TileMapCaching caching : { TileMapCaching::Chunks, TileMapCaching::ScrollBuffer }) {
+		Renderer tilemap_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+		Renderer expected_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+		const TileMapID tilemap_id = m_resources.add_tilemap(fully_tiled_level(0));
+		tilemap_renderer.clear_screen(Color::black());
+		tilemap_renderer.draw_tilemap(tilemap_id, IVec2 { 0, 0 }, caching);
+		tilemap_renderer.render(m_resources);
+		const Bitmap first_level = tilemap_renderer.bitmap();
+
+		m_resources.tilemap(tilemap_id) = fully_tiled_level(1);
+		tilemap_renderer.clear_screen(Color::black());
+		tilemap_renderer.draw_tilemap(tilemap_id, IVec2 { 0, 0 }, caching);
+		tilemap_renderer.render(m_resources);
+		expected_renderer.clear_screen(Color::black());
+		expected_renderer.draw_tilemap(tilemap_id, IVec2 { 0, 0 }, caching);
+		expected_renderer.render(m_resources);
+
+		EXPECT_NE(expected_renderer.bitmap(), first_level) << "caching " << (int)caching;
+		EXPECT_EQ(tilemap_renderer.bitmap(), expected_renderer.bitmap()) << "caching " << (int)caching;
+	}
+}
+
+TEST_F(RendererTests, DrawImage_OwnPalette_MatchesUnpalettized) {
+	ImageID sprite_sheet_id = m_resources.load_image("assets/image/render_test/sprite_sheet.png", { .indexed = true });
+	const Image& sprite_sheet = m_resources.image(sprite_sheet_id);
+	ASSERT_TRUE(sprite_sheet.is_indexed());
+
+	const Rect clip = { 16, 0, 16, 16 };
+	const std::vector<DrawImageOptions> options_to_test = {
+		{ .clip = clip },
+		{ .clip = clip, .flip_h = true, .alpha = 0.5f },
+		{ .clip = clip, .flip_v = true, .tint = Color::red().with_alpha(0.5f) },
+	};
+	for (DrawImageOptions options : options_to_test) {
+		Renderer palette_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+		Renderer image_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+		DrawImageOptions palette_options = options;
+		palette_options.palette = &sprite_sheet.palette;
+		for (auto [renderer, draw_options] : { std::pair { &palette_renderer, palette_options }, std::pair { &image_renderer, options } }) {
+			renderer->clear_screen(Color::turquoise());
+			renderer->draw_image(sprite_sheet_id, IVec2 { -4, 10 }, draw_options);
+			renderer->draw_image_scaled(sprite_sheet_id, Rect { 40, 40, 48, 32 }, draw_options);
+			renderer->render(m_resources);
+		}
+		EXPECT_EQ(palette_renderer.bitmap(), image_renderer.bitmap()) << "flip_h = " << options.flip_h << ", flip_v = " << options.flip_v;
+	}
+}
+
+TEST_F(RendererTests, DrawImage_SwappedPalette_RecolorsPixels) {
+	ImageID sprite_sheet_id = m_resources.load_image("assets/image/render_test/sprite_sheet.png", { .indexed = true });
+	const Image& sprite_sheet = m_resources.image(sprite_sheet_id);
+	Palette red_palette = sprite_sheet.palette;
+	for (int32_t i = 0; i < red_palette.size; i++) {
+		red_palette.set(i, Color::red().with_alpha(red_palette.get(i).a));
+	}
+
+	Renderer renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	renderer.clear_screen(Color::black());
+	renderer.draw_image(sprite_sheet_id, IVec2 { 0, 0 }, { .palette = &red_palette });
+	renderer.render(m_resources);
+
+	Bitmap bitmap = renderer.bitmap();
+	for (int32_t y = 0; y < sprite_sheet.height; y++) {
+		for (int32_t x = 0; x < sprite_sheet.width; x++) {
+			Pixel pixel = bitmap.get(x, y);
+			ASSERT_EQ(pixel.r, sprite_sheet.get_premultiplied(x, y).a) << "at " << x << ", " << y;
+			ASSERT_EQ(pixel.g, 0);
+			ASSERT_EQ(pixel.b, 0);
+		}
+	}
+}
+
+TEST_F(RendererTests, DrawImage_PaletteChangedAfterDrawing_UsesPaletteAtDrawTime) {
+	ImageID sprite_sheet_id = m_resources.load_image("assets/image/render_test/sprite_sheet.png", { .indexed = true });
+	const Image& sprite_sheet = m_resources.image(sprite_sheet_id);
+	Palette palette = sprite_sheet.palette;
+
+	Renderer renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	Renderer expected_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	renderer.draw_image(sprite_sheet_id, IVec2 { 10, 10 }, { .palette = &palette });
+	for (int32_t i = 0; i < palette.size; i++) {
+		palette.set(i, Color::green());
+	}
+	expected_renderer.draw_image(sprite_sheet_id, IVec2 { 10, 10 });
+
+	renderer.render(m_resources);
+	expected_renderer.render(m_resources);
+	EXPECT_EQ(renderer.bitmap(), expected_renderer.bitmap());
+}
+
+TEST_F(RendererTests, DrawImage_PaletteSmallerThanImage_IsTransparentPastSize) {
+	ImageID sprite_sheet_id = m_resources.load_image("assets/image/render_test/sprite_sheet.png", { .indexed = true });
+	const Image& sprite_sheet = m_resources.image(sprite_sheet_id);
+	ASSERT_GT(sprite_sheet.num_indexed_colors, 1);
+	const Color colors[] = { Color::red() };
+	const Palette palette = Palette::from_colors(colors);
+
+	// The rect must neither be culled nor overwritten by indices past the palette
+	Renderer renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	renderer.clear_screen(Color::black());
+	renderer.draw_rect_fill(Rect { 0, 0, sprite_sheet.width, sprite_sheet.height }, Color::blue());
+	renderer.draw_image(sprite_sheet_id, IVec2 { 0, 0 }, { .palette = &palette });
+	renderer.render(m_resources);
+
+	Image image = renderer.bitmap().to_image();
+	for (int32_t y = 0; y < sprite_sheet.height; y++) {
+		for (int32_t x = 0; x < sprite_sheet.width; x++) {
+			const Color expected = sprite_sheet.get_index(x, y) == 0 ? Color::red() : Color::blue();
+			ASSERT_EQ(image.get(x, y), expected) << "at " << x << ", " << y;
+		}
+	}
+}
+
+TEST_F(RendererTests, DrawImage_ClipOutsideImage_RepeatsEdgePixels) {
+	ImageID sprite_sheet_id = m_resources.load_image("assets/image/render_test/sprite_sheet.png");
+	const Image& sprite_sheet = m_resources.image(sprite_sheet_id);
+	const int32_t width = sprite_sheet.width;
+	const int32_t height = sprite_sheet.height;
+	const Color tint = Color::red().with_alpha(0.5f);
+
+	Renderer clamped_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	clamped_renderer.clear_screen(Color::black());
+	clamped_renderer.draw_image(sprite_sheet_id, IVec2 { 0, 0 }, { .clip = { 0, 0, width + 2, height }, .tint = tint });
+	clamped_renderer.render(m_resources);
+
+	Renderer expected_renderer = Renderer::with_bitmap(BITMAP_WIDTH, BITMAP_HEIGHT);
+	expected_renderer.clear_screen(Color::black());
+	expected_renderer.draw_image(sprite_sheet_id, IVec2 { 0, 0 }, { .tint = tint });
+	expected_renderer.draw_image(sprite_sheet_id, IVec2 { width, 0 }, { .clip = { width - 1, 0, 1, height }, .tint = tint });
+	expected_renderer.draw_image(sprite_sheet_id, IVec2 { width + 1, 0 }, { .clip = { width - 1, 0, 1, height }, .tint = tint });
+	expected_renderer.render(m_resources);
+
+	EXPECT_EQ(clamped_renderer.bitmap(), expected_renderer.bitmap());
+}
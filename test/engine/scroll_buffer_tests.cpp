@@ -0,0 +1,95 @@
+#include <gtest/gtest.h>
+
+#include <engine/graphics/bitmap.h>
+#include <engine/graphics/image.h>
+#include <engine/graphics/scroll_buffer.h>
+#include <engine/graphics/tilemap.h>
+
+#include <vector>
+
+using namespace engine;
+
+constexpr ImageID TEST_TILESET_ID = ImageID(1);
+constexpr IVec2 TEST_TILE_SIZE = { 4, 4 };
+constexpr Rect TEST_VIEW = { 0, 0, 16, 12 }; // 4x3 tiles
+
+class ScrollBufferTests : public testing::Test {
+public:
+	Image m_tileset;
+	TileMap m_tilemap;
+
+	void SetUp() override {
+		// Two solid tiles next to each other
+		std::vector<Color> colors;
+		for (int32_t y = 0; y < TEST_TILE_SIZE.y; y++) {
+			for (int32_t x = 0; x < 2 * TEST_TILE_SIZE.x; x++) {
+				colors.push_back(x < TEST_TILE_SIZE.x ? Color::red() : Color::blue());
+			}
+		}
+		m_tileset = Image::from_colors(2 * TEST_TILE_SIZE.x, TEST_TILE_SIZE.y, colors.data());
+
+		m_tilemap = TileMap::with_size(TEST_TILESET_ID, TEST_TILE_SIZE, IVec2 { 40, 40 });
+		for (int32_t y = 0; y < 40; y++) {
+			for (int32_t x = 0; x < 40; x++) {
+				m_tilemap.set_tile(x, y, (uint16_t)((x + y) % 2));
+			}
+		}
+	}
+};
+
+TEST_F(ScrollBufferTests, Update_Scrolled_OnlyCopiesExposedTiles) {
+	ScrollBuffer buffer;
+
+	buffer.update(m_tilemap, m_tileset, IVec2 { 0, 0 }, TEST_VIEW);
+	EXPECT_EQ(buffer.num_copied_tiles(), 12);
+
+	buffer.update(m_tilemap, m_tileset, IVec2 { -4, 0 }, TEST_VIEW);
+	EXPECT_EQ(buffer.num_copied_tiles(), 3) << "one column scrolled in";
+
+	buffer.update(m_tilemap, m_tileset, IVec2 { -6, -1 }, TEST_VIEW);
+	EXPECT_EQ(buffer.num_copied_tiles(), 3 + 5) << "half a column and a row scrolled in";
+
+	buffer.update(m_tilemap, m_tileset, IVec2 { -6, -1 }, TEST_VIEW);
+	EXPECT_EQ(buffer.num_copied_tiles(), 0);
+}
+
+TEST_F(ScrollBufferTests, Update_ChangedTile_CopiesTilesOfItsChunk) {
+	ScrollBuffer buffer;
+	buffer.update(m_tilemap, m_tileset, IVec2 { 0, 0 }, TEST_VIEW);
+
+	m_tilemap.set_tile(1, 1, TileMap::EMPTY_TILE);
+	buffer.update(m_tilemap, m_tileset, IVec2 { 0, 0 }, TEST_VIEW);
+
+	EXPECT_EQ(buffer.num_copied_tiles(), 12);
+}
+
+TEST_F(ScrollBufferTests, Draw_MatchesTileMapAcrossWrapAround) {
+	ScrollBuffer buffer;
+	Bitmap bitmap = Bitmap::with_size(TEST_VIEW.width, TEST_VIEW.height);
+	for (IVec2 pos : { IVec2 { 0, 0 }, IVec2 { -3, -5 }, IVec2 { -13, -2 }, IVec2 { -29, -31 }, IVec2 { -20, -10 } }) {
+		buffer.update(m_tilemap, m_tileset, pos, TEST_VIEW);
+		buffer.draw(&bitmap, TEST_VIEW);
+
+		for (int32_t y = 0; y < TEST_VIEW.height; y++) {
+			for (int32_t x = 0; x < TEST_VIEW.width; x++) {
+				IVec2 world = { x - pos.x, y - pos.y };
+				uint16_t tile = m_tilemap.tile(world.x / TEST_TILE_SIZE.x, world.y / TEST_TILE_SIZE.y);
+				Pixel expected = m_tileset.pixels[tile * TEST_TILE_SIZE.x];
+				ASSERT_EQ(bitmap.get(x, y), expected) << "pos = " << pos.x << ", " << pos.y << " at " << x << ", " << y;
+			}
+		}
+	}
+}
+
+TEST_F(ScrollBufferTests, Update_OpaqueTilesUnderView_IsOpaque) {
+	ScrollBuffer buffer;
+
+	buffer.update(m_tilemap, m_tileset, IVec2 { 0, 0 }, TEST_VIEW);
+	EXPECT_EQ(buffer.alpha_mode(), AlphaMode::Opaque) << "spare row and column aren't under view";
+
+	buffer.update(m_tilemap, m_tileset, IVec2 { 2, 0 }, TEST_VIEW);
+	EXPECT_EQ(buffer.alpha_mode(), AlphaMode::Binary) << "empty tiles left of tile map under view";
+
+	buffer.update(m_tilemap, m_tileset, IVec2 { 0, 0 }, TEST_VIEW);
+	EXPECT_EQ(buffer.alpha_mode(), AlphaMode::Opaque);
+}
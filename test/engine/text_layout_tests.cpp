@@ -0,0 +1,98 @@
+#include <gtest/gtest.h>
+
+#include <engine/file/resource_manager.h>
+#include <engine/graphics/font.h>
+#include <engine/graphics/text_layout.h>
+
+#include <algorithm>
+#include <optional>
+
+using namespace engine;
+
+constexpr int TEST_FONT_SIZE = 16;
+
+class TextLayoutTests : public testing::Test {
+public:
+	ResourceManager m_resources;
+	FontID m_test_font_id;
+
+	void SetUp() override {
+		m_test_font_id = m_resources.load_font("assets/font/ModernDOS8x16.ttf");
+		ASSERT_NE(m_test_font_id, INVALID_FONT_ID) << "Failed to load test font!";
+		m_resources.typeface(m_test_font_id).add_font(TEST_FONT_SIZE);
+	}
+
+	const Typeface& typeface() const {
+		return m_resources.typeface(m_test_font_id);
+	}
+};
+
+TEST_F(TextLayoutTests, FromText_DefaultRectSize_FitsText) {
+	TextLayout layout = TextLayout::from_text(typeface(), TEST_FONT_SIZE, IVec2 { 0, 0 }, HorizontalAlignment::Left, "Hello");
+
+	EXPECT_EQ(layout.size, (IVec2 { typeface().text_width(TEST_FONT_SIZE, "Hello"), TEST_FONT_SIZE + 1 }));
+	EXPECT_EQ(layout.glyphs.size(), 5);
+}
+
+TEST_F(TextLayoutTests, FromText_WrapsWordsThatDontFit) {
+	const int32_t word_width = typeface().text_width(TEST_FONT_SIZE, "aaaa");
+	const int32_t ascent = typeface().ascent(TEST_FONT_SIZE);
+	TextLayout layout = TextLayout::from_text(typeface(), TEST_FONT_SIZE, IVec2 { word_width, 10 * ascent }, HorizontalAlignment::Left, "aaaa aaaa");
+
+	ASSERT_EQ(layout.glyphs.size(), 8);
+	EXPECT_EQ(layout.glyphs[0].pos.x, layout.glyphs[4].pos.x);
+	EXPECT_EQ(layout.glyphs[0].pos.y + ascent, layout.glyphs[4].pos.y);
+}
+
+TEST_F(TextLayoutTests, Cache_SameText_IsHit) {
+	TextLayoutCache cache;
+
+	auto first = cache.layout(typeface(), m_test_font_id, TEST_FONT_SIZE, IVec2 { 100, 20 }, HorizontalAlignment::Left, "Start game");
+	auto second = cache.layout(typeface(), m_test_font_id, TEST_FONT_SIZE, IVec2 { 100, 20 }, HorizontalAlignment::Left, "Start game");
+
+	EXPECT_EQ(first, second);
+	EXPECT_EQ(cache.stats().hits, 1);
+	EXPECT_EQ(cache.stats().misses, 1);
+}
+
+TEST_F(TextLayoutTests, Cache_DifferentAlignment_IsMiss) {
+	TextLayoutCache cache;
+
+	auto left = cache.layout(typeface(), m_test_font_id, TEST_FONT_SIZE, IVec2 { 100, 20 }, HorizontalAlignment::Left, "Start game");
+	auto center = cache.layout(typeface(), m_test_font_id, TEST_FONT_SIZE, IVec2 { 100, 20 }, HorizontalAlignment::Center, "Start game");
+
+	EXPECT_NE(left, center);
+	EXPECT_EQ(cache.stats().hits, 0);
+	EXPECT_EQ(cache.stats().misses, 2);
+}
+
+TEST_F(TextLayoutTests, Cache_OverCapacity_EvictsLeastRecentlyUsed) {
+	TextLayoutCache cache = TextLayoutCache(2);
+	auto layout = [&](const std::string& text) {
+		return cache.layout(typeface(), m_test_font_id, TEST_FONT_SIZE, IVec2 { 100, 20 }, HorizontalAlignment::Left, text);
+	};
+
+	layout("Start game");
+	layout("Options");
+	layout("Start game");
+	layout("Quit");
+	EXPECT_EQ(cache.size(), 2);
+	EXPECT_EQ(cache.stats().misses, 3);
+
+	layout("Start game");
+	EXPECT_EQ(cache.stats().hits, 2);
+	layout("Options");
+	EXPECT_EQ(cache.stats().misses, 4);
+}
+
+TEST_F(TextLayoutTests, Typeface_Copy_GlyphsPointIntoOwnAtlas) {
+	std::optional<Typeface> copy = typeface();
+	const Glyph& original_glyph = typeface().glyph(TEST_FONT_SIZE, 'g');
+	const Glyph& copied_glyph = copy->glyph(TEST_FONT_SIZE, 'g');
+
+	ASSERT_GT(copied_glyph.width * copied_glyph.height, 0);
+	EXPECT_NE(copied_glyph.pixels, original_glyph.pixels);
+	for (int32_t y = 0; y < copied_glyph.height; y++) {
+		EXPECT_TRUE(std::equal(copied_glyph.row(y), copied_glyph.row(y) + copied_glyph.width, original_glyph.row(y))) << "at row " << y;
+	}
+}
@@ -0,0 +1,53 @@
+#include <gtest/gtest.h>
+
+#include <engine/graphics/tilemap.h>
+
+using namespace engine;
+
+constexpr ImageID TEST_TILESET_ID = ImageID(1);
+constexpr IVec2 TEST_TILE_SIZE = { 16, 16 };
+
+TEST(TileMapTests, WithSize_StartsEmpty) {
+	TileMap tilemap = TileMap::with_size(TEST_TILESET_ID, TEST_TILE_SIZE, IVec2 { 20, 11 });
+
+	EXPECT_EQ(tilemap.pixel_size(), (IVec2 { 320, 176 }));
+	EXPECT_EQ(tilemap.num_chunks(), (IVec2 { 2, 1 }));
+	EXPECT_EQ(tilemap.tile(19, 10), TileMap::EMPTY_TILE);
+}
+
+TEST(TileMapTests, SetTile_OnlyBumpsVersionOfItsChunk) {
+	TileMap tilemap = TileMap::with_size(TEST_TILESET_ID, TEST_TILE_SIZE, IVec2 { 40, 20 });
+
+	tilemap.set_tile(17, 3, 5);
+
+	EXPECT_EQ(tilemap.tile(17, 3), 5);
+	EXPECT_EQ(tilemap.chunk_version(0, 0), 0);
+	EXPECT_EQ(tilemap.chunk_version(1, 0), 1);
+	EXPECT_EQ(tilemap.chunk_version(1, 1), 0);
+	EXPECT_EQ(tilemap.version(), 1);
+}
+
+TEST(TileMapTests, SetTile_SameTileOrOutside_KeepsVersion) {
+	TileMap tilemap = TileMap::with_size(TEST_TILESET_ID, TEST_TILE_SIZE, IVec2 { 4, 4 });
+	tilemap.set_tile(1, 1, 2);
+
+	tilemap.set_tile(1, 1, 2);
+	tilemap.set_tile(-1, 0, 2);
+	tilemap.set_tile(4, 0, 2);
+
+	EXPECT_EQ(tilemap.version(), 1);
+}
+
+TEST(TileMapTests, Assign_ChangesIdentity) {
+	TileMap tilemap = TileMap::with_size(TEST_TILESET_ID, TEST_TILE_SIZE, IVec2 { 4, 4 });
+	const uint64_t identity = tilemap.identity();
+
+	tilemap.set_tile(1, 1, 2);
+	EXPECT_EQ(tilemap.identity(), identity);
+
+	const TileMap copy = tilemap;
+	tilemap = TileMap::with_size(TEST_TILESET_ID, TEST_TILE_SIZE, IVec2 { 4, 4 });
+	EXPECT_NE(copy.identity(), identity);
+	EXPECT_NE(tilemap.identity(), identity);
+	EXPECT_NE(tilemap.identity(), copy.identity());
+}
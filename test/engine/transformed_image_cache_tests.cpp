@@ -0,0 +1,91 @@
+#include <gtest/gtest.h>
+
+#include <engine/graphics/transformed_image_cache.h>
+
+#include <vector>
+
+using namespace engine;
+
+constexpr ImageID TEST_IMAGE_ID = ImageID(1);
+constexpr Color RED = { 255, 0, 0, 255 };
+constexpr Color GREEN = { 0, 255, 0, 255 };
+constexpr Color BLUE = { 0, 0, 255, 255 };
+constexpr Color WHITE = { 255, 255, 255, 255 };
+
+class TransformedImageCacheTests : public testing::Test {
+public:
+	Image m_image;
+
+	void SetUp() override {
+		// clang-format off
+		std::vector<Color> colors = {
+			RED,  GREEN, BLUE,
+			BLUE, WHITE, RED,
+		};
+		// clang-format on
+		m_image = Image::from_colors(3, 2, colors.data());
+	}
+};
+
+TEST_F(TransformedImageCacheTests, Image_FlipsWithinClip) {
+	TransformedImageCache cache;
+
+	auto image = cache.image(m_image, TEST_IMAGE_ID, Rect { 1, 0, 2, 2 }, true, true, Color::white());
+
+	ASSERT_EQ(image->width, 2);
+	ASSERT_EQ(image->height, 2);
+	EXPECT_EQ(image->get(0, 0), RED);
+	EXPECT_EQ(image->get(1, 0), WHITE);
+	EXPECT_EQ(image->get(0, 1), BLUE);
+	EXPECT_EQ(image->get(1, 1), GREEN);
+}
+
+TEST_F(TransformedImageCacheTests, Image_AppliesTint) {
+	TransformedImageCache cache;
+	const Color tint = { 255, 0, 0, 255 };
+
+	auto image = cache.image(m_image, TEST_IMAGE_ID, Rect { 0, 1, 3, 1 }, false, false, tint);
+
+	EXPECT_EQ(image->get(0, 0), (Color { 0, 0, 0, 255 }));
+	EXPECT_EQ(image->get(1, 0), (Color { 255, 0, 0, 255 }));
+	EXPECT_EQ(image->get(2, 0), (Color { 255, 0, 0, 255 }));
+}
+
+TEST_F(TransformedImageCacheTests, Image_SameTransform_IsHit) {
+	TransformedImageCache cache;
+
+	auto first = cache.image(m_image, TEST_IMAGE_ID, Rect { 0, 0, 3, 2 }, true, false, Color::white());
+	auto second = cache.image(m_image, TEST_IMAGE_ID, Rect { 0, 0, 3, 2 }, true, false, Color::white());
+	auto flipped_v = cache.image(m_image, TEST_IMAGE_ID, Rect { 0, 0, 3, 2 }, false, true, Color::white());
+
+	EXPECT_EQ(first, second);
+	EXPECT_NE(first, flipped_v);
+	EXPECT_EQ(cache.stats().hits, 1);
+	EXPECT_EQ(cache.stats().misses, 2);
+	EXPECT_EQ(cache.stats().bytes, 2 * m_image.pixels.size() * sizeof(Pixel));
+}
+
+TEST_F(TransformedImageCacheTests, Image_OverBudget_EvictsLeastRecentlyUsed) {
+	const size_t image_bytes = m_image.pixels.size() * sizeof(Pixel);
+	TransformedImageCache cache = TransformedImageCache(2 * image_bytes);
+	auto image = [&](Color tint) {
+		return cache.image(m_image, TEST_IMAGE_ID, Rect { 0, 0, 3, 2 }, false, false, tint);
+	};
+
+	image(RED);
+	image(GREEN);
+	image(RED);
+	image(BLUE);
+	EXPECT_EQ(cache.size(), 2);
+	EXPECT_EQ(cache.stats().evictions, 1);
+	EXPECT_EQ(cache.stats().bytes, 2 * image_bytes);
+
+	image(RED);
+	EXPECT_EQ(cache.stats().hits, 2);
+	image(GREEN);
+	EXPECT_EQ(cache.stats().misses, 4);
+
+	cache.set_budget(0);
+	EXPECT_EQ(cache.size(), 0);
+	EXPECT_EQ(cache.stats().bytes, 0);
+}
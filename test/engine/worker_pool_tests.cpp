@@ -0,0 +1,43 @@
+#include <gtest/gtest.h>
+
+#include <engine/utility/worker_pool.h>
+
+#include <atomic>
+#include <mutex>
+#include <set>
+#include <thread>
+
+using namespace engine;
+
+TEST(WorkerPoolTests, Run_CallsJobOncePerThread) {
+	WorkerPool pool;
+	std::mutex mutex;
+	std::multiset<std::thread::id> thread_ids;
+
+	pool.run(4, [&] {
+		std::lock_guard lock(mutex);
+		thread_ids.insert(std::this_thread::get_id());
+	});
+
+	EXPECT_EQ(thread_ids.size(), 4);
+	EXPECT_EQ(std::set<std::thread::id>(thread_ids.begin(), thread_ids.end()).size(), 4);
+	EXPECT_EQ(thread_ids.count(std::this_thread::get_id()), 1) << "calling thread works on job too";
+}
+
+TEST(WorkerPoolTests, Run_KeepsWorkersBetweenJobs) {
+	WorkerPool pool;
+	std::atomic<int32_t> num_calls = 0;
+	auto job = [&] { num_calls++; };
+
+	pool.run(4, job);
+	pool.run(2, job);
+	EXPECT_EQ(num_calls, 4 + 2);
+	EXPECT_EQ(pool.num_workers(), 3);
+
+	pool.stop();
+	EXPECT_EQ(pool.num_workers(), 0);
+
+	pool.run(3, job);
+	EXPECT_EQ(num_calls, 4 + 2 + 3);
+	EXPECT_EQ(pool.num_workers(), 2);
+}
@@ -278,13 +278,15 @@ namespace testing {
 
 	void save_snapshot(const engine::Image& snapshot, std::string test_suite_name, std::string test_name) {
 		std::filesystem::create_directories(snapshot_directory(test_suite_name));
-		int _result = stbi_write_png(snapshot_filepath(test_suite_name, test_name).c_str(), snapshot.width, snapshot.height, 4, snapshot.pixels.data(), snapshot.width * 4);
+		const std::vector<engine::Color> colors = snapshot.to_colors();
+		int _result = stbi_write_png(snapshot_filepath(test_suite_name, test_name).c_str(), snapshot.width, snapshot.height, 4, colors.data(), snapshot.width * 4);
 		DEBUG_ASSERT(_result != 0, "stbi_write_png failed");
 	}
 
 	void save_snapshot_diff(const engine::Image& snapshot, std::string test_suite_name, std::string test_name) {
 		std::filesystem::create_directories(snapshot_report_directory(test_suite_name));
-		int _result = stbi_write_png(snapshot_diff_filepath(test_suite_name, test_name).c_str(), snapshot.width, snapshot.height, 4, snapshot.pixels.data(), snapshot.width * 4);
+		const std::vector<engine::Color> colors = snapshot.to_colors();
+		int _result = stbi_write_png(snapshot_diff_filepath(test_suite_name, test_name).c_str(), snapshot.width, snapshot.height, 4, colors.data(), snapshot.width * 4);
 		DEBUG_ASSERT(_result != 0, "stbi_write_png failed");
 	}
 